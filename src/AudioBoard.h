@@ -4,6 +4,70 @@
 
 namespace audio_driver {
 
+class AudioBoard;
+
+/**
+ * @brief Transaction returned by AudioBoard::edit(): collects the changes of
+ * the rate, format, routing, volume, mute and input volume, which are applied
+ * together by commit()
+ * @ingroup audio_driver
+ */
+class AudioBoardEdit {
+ public:
+  AudioBoardEdit(AudioBoard& board, CodecConfig cfg) : p_board(&board) {
+    changes.cfg = cfg;
+  }
+
+  AudioBoardEdit& setConfig(CodecConfig cfg) {
+    changes.cfg = cfg;
+    return *this;
+  }
+  AudioBoardEdit& setSampleRate(int rate) {
+    changes.cfg.setRateNumeric(rate);
+    return *this;
+  }
+  AudioBoardEdit& setBits(int bits) {
+    changes.cfg.setBitsNumeric(bits);
+    return *this;
+  }
+  AudioBoardEdit& setChannels(int channels) {
+    changes.cfg.setChannelsNumeric(channels);
+    return *this;
+  }
+  AudioBoardEdit& setFormat(i2s_format_t fmt) {
+    changes.cfg.i2s.fmt = fmt;
+    return *this;
+  }
+  AudioBoardEdit& setInput(input_device_t input) {
+    changes.cfg.input_device = input;
+    return *this;
+  }
+  AudioBoardEdit& setOutput(output_device_t output) {
+    changes.cfg.output_device = output;
+    return *this;
+  }
+  AudioBoardEdit& setVolume(int volume) {
+    changes.volume = volume;
+    return *this;
+  }
+  AudioBoardEdit& setInputVolume(int volume) {
+    changes.input_volume = volume;
+    return *this;
+  }
+  AudioBoardEdit& setMute(bool enable) {
+    changes.mute = enable;
+    changes.mute_changed = true;
+    return *this;
+  }
+
+  /// Applies the changes which differ from the current state of the board
+  bool commit();
+
+ protected:
+  AudioBoard* p_board;
+  DriverChanges changes;
+};
+
 /**
  * @brief Defitintion for audio board pins and an audio driver
  * @ingroup audio_driver
@@ -43,6 +107,30 @@ class AudioBoard {
     return begin();
   }
 
+  /// Starts the processing from a blob created by saveState() w/o the full
+  /// codec initialization: returns false if the state is not valid, so that
+  /// you can fall back to begin()
+  bool begin(const uint8_t* state, size_t len) {
+    AD_LOGD("AudioBoard::begin(state)");
+    if (p_pins == nullptr) {
+      AD_LOGE("pins are null");
+      return false;
+    }
+    if (!p_driver->beginFromState(*p_pins, state, len)) {
+      AD_LOGE("AudioBoard::driver::beginFromState failed");
+      return false;
+    }
+    // report the restored volume of the driver
+    volume = -1;
+    is_active = true;
+    return true;
+  }
+
+  /// Saves the codec registers and settings: see AudioDriver::saveState()
+  size_t saveState(uint8_t* buffer, size_t len) {
+    return p_driver->saveState(buffer, len);
+  }
+
   /// Updates the CodecConfig values -> reconfigures the codec only
   bool setConfig(CodecConfig cfg) {
     this->codec_cfg = cfg;
@@ -54,7 +142,40 @@ class AudioBoard {
     is_active = false;
     return p_driver->end();
   }
-  bool setMute(bool enable) { return p_driver->setMute(enable); }
+  /// Starts a transaction: e.g. board.edit().setSampleRate(48000)
+  /// .setVolume(70).commit() changes the rate and volume with one mute
+  /// window and one register burst
+  AudioBoardEdit edit() { return AudioBoardEdit(*this, codec_cfg); }
+
+  /// Applies the changes of an edit() which differ from the current state
+  bool commit(DriverChanges changes) {
+    if (!is_active) {
+      AD_LOGE("AudioBoard::commit: board not started");
+      return false;
+    }
+    changes.cfg_changed = !changes.cfg.equalsExRate(codec_cfg) ||
+                          changes.cfg.i2s.rate != codec_cfg.i2s.rate;
+    if (changes.volume == volume) changes.volume = -1;
+    if (changes.input_volume == input_volume) changes.input_volume = -1;
+    if (!changes.mute_changed || changes.mute == is_muted) {
+      changes.mute = is_muted;
+      changes.mute_changed = false;
+    }
+    if (!changes.cfg_changed && changes.volume < 0 &&
+        changes.input_volume < 0 && !changes.mute_changed)
+      return true;
+    bool result = p_driver->applyChanges(changes);
+    codec_cfg = changes.cfg;
+    if (changes.volume >= 0) volume = changes.volume;
+    if (changes.input_volume >= 0) input_volume = changes.input_volume;
+    is_muted = changes.mute;
+    return result;
+  }
+
+  bool setMute(bool enable) {
+    is_muted = enable;
+    return p_driver->setMute(enable);
+  }
   bool setMute(bool enable, int line) {
     if (line == power_amp_line) setPAPower(!enable);
     return p_driver->setMute(enable, line);
@@ -88,7 +209,10 @@ class AudioBoard {
   }
 
   /// set volume for adc: this is only supported on some defined codecs
-  bool setInputVolume(int volume) { return p_driver->setInputVolume(volume); }
+  bool setInputVolume(int volume) {
+    input_volume = volume;
+    return p_driver->setInputVolume(volume);
+  }
 
   // platform specific logic to determine if key is pressed
   bool isKeyPressed(uint8_t key) { return p_pins->isKeyPressed(key); }
@@ -103,9 +227,13 @@ class AudioBoard {
   CodecConfig codec_cfg;
   int power_amp_line = ES8388_PA_LINE;
   int volume = -1;
+  int input_volume = -1;
+  bool is_muted = false;
   bool is_active = false;
 };
 
+inline bool AudioBoardEdit::commit() { return p_board->commit(changes); }
+
 /// @ingroup audio_driver
 static AudioBoard NoBoard{NoDriver, NoPins};
 /// @ingroup audio_driver
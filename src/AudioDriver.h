@@ -5,6 +5,10 @@
 #include "DriverDeviceInfo.h"
 #include "Platforms/API_Delay.h"
 #include "Platforms/API_GPIO.h"
+#include "Platforms/StateBlob.h"
+#if AUDIO_DRIVER_ASYNC_I2C
+#  include "Platforms/I2CCommandQueue.h"
+#endif
 
 namespace audio_driver {
 
@@ -173,6 +177,24 @@ class CodecConfig : public codec_config_t {
   bool sdmmc_active = false;
 };
 
+/**
+ * @brief Changes which are applied together by AudioDriver::applyChanges():
+ * see AudioBoard::edit()
+ * @ingroup audio_driver
+ */
+struct DriverChanges {
+  /// new rate, format and routing
+  CodecConfig cfg;
+  bool cfg_changed = false;
+  /// new volume or -1 if unchanged
+  int volume = -1;
+  /// new input volume or -1 if unchanged
+  int input_volume = -1;
+  /// mute state at the end of the transaction
+  bool mute = false;
+  bool mute_changed = false;
+};
+
 /**
  * @brief Abstract Driver API for codec chips
  * @ingroup audio_driver
@@ -184,22 +206,7 @@ class AudioDriver {
   /// Starts the processing
   virtual bool begin(CodecConfig codecCfg, DriverDeviceInfo& pins) {
     AD_LOGI("AudioDriver::begin");
-    p_pins = &pins;
-
-    // start GPIO
-    getGPIO().begin(pins);
-
-    // Store default i2c address to pins
-    setupI2CAddress();
-
-    AD_LOGI("sd_active: %d", codecCfg.sd_active);
-    p_pins->setSPIActiveForSD(codecCfg.sd_active);
-    AD_LOGI("sdmmc_active: %d", codecCfg.sdmmc_active);
-    p_pins->setSDMMCActive(codecCfg.sdmmc_active);
-    if (!p_pins->begin()) {
-      AD_LOGE("AudioBoard::pins::begin failed");
-      return false;
-    }
+    if (!beginPins(codecCfg, pins)) return false;
 
     if (!setConfig(codecCfg)) {
       AD_LOGE("setConfig has failed");
@@ -211,26 +218,218 @@ class AudioDriver {
     return true;
   }
 
+  /// State of the non-blocking begin: see beginAsync()
+  enum class BeginState { Idle, Busy, Done, Failed };
+
+  /// Starts the processing w/o blocking: call poll() (e.g. in loop()) until
+  /// it does not return BeginState::Busy any more. The settle delays of the
+  /// codec (e.g. after a reset) are spent outside of the driver.
+  bool beginAsync(CodecConfig codecCfg, DriverDeviceInfo& pins) {
+    AD_LOGI("AudioDriver::beginAsync");
+    begin_cfg = codecCfg;
+    p_begin_pins = &pins;
+    begin_config = false;
+    begin_step = 0;
+    begin_wait_ms = 0;
+    begin_state = BeginState::Busy;
+    return true;
+  }
+
+  /// setConfig() w/o blocking for a driver which has been set up with
+  /// setPins(): call poll() until it does not return BeginState::Busy any
+  /// more. Used by composite drivers to configure their codecs in parallel.
+  bool setConfigAsync(CodecConfig codecCfg) {
+    AD_LOGI("AudioDriver::setConfigAsync");
+    begin_cfg = codecCfg;
+    begin_config = true;
+    begin_step = 0;
+    begin_wait_ms = 0;
+    begin_state = BeginState::Busy;
+    return true;
+  }
+
+  /// Executes the next steps of beginAsync() if they are due
+  BeginState poll() { return poll(uptimeMs()); }
+
+  /// Executes the next steps of beginAsync() if they are due at the
+  /// indicated time in ms (e.g. a virtual clock)
+  BeginState poll(uint32_t nowMs) {
+    begin_now_ms = nowMs;
+    while (begin_state == BeginState::Busy) {
+      if (nowMs - begin_since_ms < begin_wait_ms) break;
+      int rc = begin_config ? configStep(begin_step++)
+                            : beginStep(begin_step++);
+      if (rc == STEP_DONE) {
+        AD_LOGI("AudioDriver::beginAsync done in %d steps", begin_step);
+        begin_state = BeginState::Done;
+      } else if (rc < 0) {
+        AD_LOGE("AudioDriver::beginAsync failed in step %d", begin_step - 1);
+        begin_state = BeginState::Failed;
+      } else {
+        begin_since_ms = nowMs;
+        begin_wait_ms = rc;
+      }
+    }
+    return begin_state;
+  }
+
+  /// Provides the state of the non-blocking begin
+  BeginState beginState() { return begin_state; }
+
+  /// Number of executed steps of the non-blocking begin
+  int beginProgress() { return begin_step; }
+
+  /// Time in ms until the next step of the non-blocking begin is due
+  uint32_t pollDelay(uint32_t nowMs) {
+    if (begin_state != BeginState::Busy) return 0;
+    uint32_t passed = nowMs - begin_since_ms;
+    return passed < begin_wait_ms ? begin_wait_ms - passed : 0;
+  }
+
+  /// Starts the processing from a blob created by saveState(): init(),
+  /// controlState() and configInterface() are skipped and the saved registers
+  /// are written instead. The codec is expected to be in its power-on state.
+  bool beginFromState(DriverDeviceInfo& pins, const uint8_t* state,
+                      size_t len) {
+    AD_LOGI("AudioDriver::beginFromState");
+    // the pins (e.g. sd_active) are set up with the saved configuration
+    CodecConfig cfg;
+    StateBlobReader in(state, len);
+    if (!in.beginBlob() || !readStateConfig(in, cfg)) {
+      AD_LOGE("beginFromState: invalid state");
+      return false;
+    }
+    if (!beginPins(cfg, pins)) return false;
+    if (!restoreState(state, len)) {
+      AD_LOGE("restoreState has failed");
+      return false;
+    }
+    setPAPower(true);
+    return true;
+  }
+
+  /// Serialises the codec registers, the CodecConfig and the volume and mute
+  /// settings into a compact versioned blob (e.g. to be stored in NVS):
+  /// returns the size or 0 if not supported or the buffer is too small
+  size_t saveState(uint8_t* buffer, size_t len) {
+    StateBlobWriter out(buffer, len);
+    out.beginBlob();
+    out.put8((uint8_t)codec_cfg.input_device);
+    out.put8((uint8_t)codec_cfg.output_device);
+    out.put8((uint8_t)codec_cfg.i2s.mode);
+    out.put8((uint8_t)codec_cfg.i2s.fmt);
+    out.put8((uint8_t)codec_cfg.i2s.rate);
+    out.put8((uint8_t)codec_cfg.i2s.bits);
+    out.put8((uint8_t)codec_cfg.i2s.channels);
+    out.put8((uint8_t)codec_cfg.i2s.signal_type);
+    out.put8((uint8_t)((codec_cfg.sd_active ? 1 : 0) |
+                       (codec_cfg.sdmmc_active ? 2 : 0)));
+    if (!saveDriverState(out)) {
+      AD_LOGE("saveState not supported or buffer too small");
+      return 0;
+    }
+    return out.endBlob();
+  }
+
+  /// Restores a blob created by saveState() on a codec in its power-on
+  /// state: the registers are replayed in bursts
+  bool restoreState(const uint8_t* buffer, size_t len) {
+    StateBlobReader in(buffer, len);
+    if (!in.beginBlob()) {
+      AD_LOGE("restoreState: invalid state");
+      return false;
+    }
+    CodecConfig cfg;
+    if (!readStateConfig(in, cfg) || !restoreDriverState(in)) return false;
+    codec_cfg = cfg;
+    return true;
+  }
+
   /// changes the configuration
   virtual bool setConfig(CodecConfig codecCfg) {
     AD_LOGI("AudioDriver::setConfig");
-    codec_cfg = codecCfg;
-    if (!init(codec_cfg)) {
-      AD_LOGE("AudioDriver init failed");
-      return false;
+    // collect the register writes and send only the final values
+    bool deferred = deferred_config && !in_changes && beginDeferred();
+    bool result = applyConfig(codecCfg);
+    if (deferred && !flush()) {
+      AD_LOGE("AudioDriver flush failed");
+      result = false;
     }
-    codec_mode_t codec_mode = codec_cfg.get_mode();
-    if (!controlState(codec_mode)) {
-      AD_LOGE("AudioDriver controlState failed");
+    return result;
+  }
+
+  /// Changes only the sample rate: drivers with a fast path reprogram only
+  /// the clock registers inside a short mute window, all others fall back to
+  /// a full setConfig()
+  bool setSampleRate(int rate) {
+    if (p_pins == nullptr) {
+      AD_LOGE("setSampleRate: driver not started");
       return false;
     }
-    bool result = configInterface(codec_mode, codec_cfg.i2s);
-    if (!result) {
-      AD_LOGE("AudioDriver configInterface failed");
-      return false;
+    CodecConfig cfg = codec_cfg;
+    cfg.setRateNumeric(rate);
+    if (cfg.i2s.rate == codec_cfg.i2s.rate) return true;
+    if (configSampleRate(cfg.i2s.rate)) {
+      codec_cfg.i2s.rate = cfg.i2s.rate;
+      return true;
+    }
+    AD_LOGI("setSampleRate: full reinit");
+    return setConfig(cfg);
+  }
+
+  /// Applies several changes with a single register burst: the output is
+  /// muted at most once, while the rate, format or routing are changed.
+  /// Drivers with a register cache only send the registers which have
+  /// changed. The routing or format is only deferred if setDeferredConfig()
+  /// is active.
+  bool applyChanges(DriverChanges changes) {
+    bool rate_only = changes.cfg_changed &&
+                     changes.cfg.equalsExRate(codec_cfg) && p_pins != nullptr;
+    bool reconfig = changes.cfg_changed && !rate_only;
+    bool result = true;
+    // mute window
+    if (changes.cfg_changed && !setMute(true)) result = false;
+    in_changes = true;
+    bool deferred = (!reconfig || deferred_config) && beginDeferred();
+    if (rate_only) {
+      if (configSampleRate(changes.cfg.i2s.rate)) {
+        codec_cfg.i2s.rate = changes.cfg.i2s.rate;
+      } else {
+        AD_LOGI("applyChanges: full reinit");
+        reconfig = true;
+        // nothing has been written yet
+        if (deferred && !deferred_config) {
+          flush();
+          deferred = false;
+        }
+      }
+    }
+    if (reconfig && !setConfig(changes.cfg)) result = false;
+    if (changes.volume >= 0 && !setVolume(changes.volume)) result = false;
+    if (changes.input_volume >= 0 && !setInputVolume(changes.input_volume))
+      result = false;
+    if (!changes.cfg_changed && changes.mute_changed &&
+        !setMute(changes.mute))
+      result = false;
+    if (deferred && !flush()) {
+      AD_LOGE("AudioDriver flush failed");
+      result = false;
     }
+    in_changes = false;
+    if (changes.cfg_changed && !changes.mute && !setMute(false))
+      result = false;
     return result;
   }
+
+  /// Register writes only update the register cache until flush() is
+  /// called: returns false if not supported by the driver
+  virtual bool beginDeferred() { return false; }
+  /// Writes the registers changed since beginDeferred() sorted by address
+  virtual bool flush() { return true; }
+  /// Configuration: setConfig() uses the deferred mode, so that registers
+  /// which are written multiple times are sent only once. Only activate this
+  /// if the codec does not depend on the order of the writes.
+  void setDeferredConfig(bool active) { deferred_config = active; }
   /// Ends the processing: shut down dac and adc
   virtual bool end(void) { return deinit(); }
   /// Mutes all output lines
@@ -251,6 +450,10 @@ class AudioDriver {
   virtual bool isVolumeSupported() { return true; }
   /// Determines if setInputVolume() is supported
   virtual bool isInputVolumeSupported() { return false; }
+  /// Restores the codec registers after a reset or power cycle (e.g. deep
+  /// sleep) w/o a full begin(): only supported by drivers with a register
+  /// cache
+  virtual bool resync() { return false; }
   /// Provides the pin information
   virtual DriverDeviceInfo& pins() { return *p_pins; }
 
@@ -318,10 +521,65 @@ class AudioDriver {
     return p_pins->getGPIO();
   }
 
+#if AUDIO_DRIVER_ASYNC_I2C
+  /// Defines the queue which executes the ...Async() methods. If no queue is
+  /// defined they are executed synchronously.
+  void setCommandQueue(I2CCommandQueue* queue) { p_queue = queue; }
+
+  /// Queues setMute(): the optional completion is updated by the worker
+  bool setMuteAsync(bool enable, I2CCompletion* completion = nullptr) {
+    return submit(opSetMute, enable, completion);
+  }
+
+  /// Queues setVolume(): the optional completion is updated by the worker
+  bool setVolumeAsync(int volume, I2CCompletion* completion = nullptr) {
+    return submit(opSetVolume, volume, completion);
+  }
+
+  /// Queues setInputVolume(): the optional completion is updated by the worker
+  bool setInputVolumeAsync(int volume, I2CCompletion* completion = nullptr) {
+    return submit(opSetInputVolume, volume, completion);
+  }
+#endif
+
  protected:
   CodecConfig codec_cfg;
   DriverDeviceInfo* p_pins = nullptr;
   int i2c_default_address = -1;
+  bool deferred_config = DRIVER_DEFERRED_CONFIG;
+  bool in_changes = false;
+  CodecConfig begin_cfg;
+  DriverDeviceInfo* p_begin_pins = nullptr;
+  BeginState begin_state = BeginState::Idle;
+  bool begin_config = false;
+  int begin_step = 0;
+  uint32_t begin_since_ms = 0;
+  uint32_t begin_wait_ms = 0;
+  /// time in ms of the current poll(): passed on by composite drivers
+  uint32_t begin_now_ms = 0;
+  /// step of configStepStandard() which executes controlStateStep(0)
+  int state_step_from = -1;
+#if AUDIO_DRIVER_ASYNC_I2C
+  I2CCommandQueue* p_queue = nullptr;
+
+  bool submit(error_t (*op)(void*, int), int arg, I2CCompletion* completion) {
+    I2CCommand cmd = I2CCommand::call(op, this, arg, completion);
+    if (p_queue == nullptr) return cmd.execute() == RESULT_OK;
+    return p_queue->enqueue(cmd);
+  }
+
+  static error_t opSetMute(void* ref, int arg) {
+    return ((AudioDriver*)ref)->setMute(arg != 0) ? RESULT_OK : RESULT_FAIL;
+  }
+
+  static error_t opSetVolume(void* ref, int arg) {
+    return ((AudioDriver*)ref)->setVolume(arg) ? RESULT_OK : RESULT_FAIL;
+  }
+
+  static error_t opSetInputVolume(void* ref, int arg) {
+    return ((AudioDriver*)ref)->setInputVolume(arg) ? RESULT_OK : RESULT_FAIL;
+  }
+#endif
 
   int mapVolume(int x, int in_min, int in_max, int out_min, int out_max) {
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
@@ -338,6 +596,152 @@ class AudioDriver {
     return result;
   }
 
+  /// Starts the GPIOs and the pins: common part of begin() and beginFromState()
+  bool beginPins(CodecConfig& codecCfg, DriverDeviceInfo& pins) {
+    p_pins = &pins;
+
+    // start GPIO
+    getGPIO().begin(pins);
+
+    // Store default i2c address to pins
+    setupI2CAddress();
+
+    AD_LOGI("sd_active: %d", codecCfg.sd_active);
+    p_pins->setSPIActiveForSD(codecCfg.sd_active);
+    AD_LOGI("sdmmc_active: %d", codecCfg.sdmmc_active);
+    p_pins->setSDMMCActive(codecCfg.sdmmc_active);
+    if (!p_pins->begin()) {
+      AD_LOGE("AudioBoard::pins::begin failed");
+      return false;
+    }
+    return true;
+  }
+
+  /// Driver specific part of saveState(): the register image and the driver
+  /// fields (e.g. volume and mute)
+  virtual bool saveDriverState(StateBlobWriter& out) { return false; }
+  /// Driver specific part of restoreState(): the counterpart of
+  /// saveDriverState()
+  virtual bool restoreDriverState(StateBlobReader& in) { return false; }
+
+  /// Reads the CodecConfig part of a saveState() blob
+  static bool readStateConfig(StateBlobReader& in, CodecConfig& cfg) {
+    cfg.input_device = (input_device_t)in.get8();
+    cfg.output_device = (output_device_t)in.get8();
+    cfg.i2s.mode = (i2s_master_slave_t)in.get8();
+    cfg.i2s.fmt = (i2s_format_t)in.get8();
+    cfg.i2s.rate = (samplerate_t)in.get8();
+    cfg.i2s.bits = (sample_bits_t)(int8_t)in.get8();
+    cfg.i2s.channels = (channels_t)in.get8();
+    cfg.i2s.signal_type = (signal_t)in.get8();
+    uint8_t sd_flags = in.get8();
+    cfg.sd_active = sd_flags & 1;
+    cfg.sdmmc_active = sd_flags & 2;
+    return (bool)in;
+  }
+
+  /// init(), controlState() and configInterface() of setConfig()
+  bool applyConfig(CodecConfig& codecCfg) {
+    codec_cfg = codecCfg;
+    if (!init(codec_cfg)) {
+      AD_LOGE("AudioDriver init failed");
+      return false;
+    }
+    codec_mode_t codec_mode = codec_cfg.get_mode();
+    if (!controlState(codec_mode)) {
+      AD_LOGE("AudioDriver controlState failed");
+      return false;
+    }
+    bool result = configInterface(codec_mode, codec_cfg.i2s);
+    if (!result) {
+      AD_LOGE("AudioDriver configInterface failed");
+      return false;
+    }
+    return result;
+  }
+
+  /// Step of beginAsync(): executes the indicated step and returns the delay
+  /// in ms before the next step, STEP_DONE or STEP_FAILED. By default the
+  /// blocking begin() is executed as a single step.
+  virtual int beginStep(int step) {
+    return begin(begin_cfg, *p_begin_pins) ? STEP_DONE : STEP_FAILED;
+  }
+
+  /// Steps of the standard begin(): beginPins(), the steps of
+  /// configStepStandard(), PA power and default volume
+  int beginStepStandard(int step) {
+    if (step == 0) {
+      if (!beginPins(begin_cfg, *p_begin_pins)) return STEP_FAILED;
+      return 0;
+    }
+    int rc = configStepStandard(step - 1);
+    if (rc != STEP_DONE) return rc;
+    setPAPower(true);
+    setVolume(DRIVER_DEFAULT_VOLUME);
+    return STEP_DONE;
+  }
+
+  /// Step of setConfigAsync(): by default the blocking setConfig() is
+  /// executed as a single step
+  virtual int configStep(int step) {
+    return setConfig(begin_cfg) ? STEP_DONE : STEP_FAILED;
+  }
+
+  /// Steps of the standard setConfig(): the steps of initStep() and
+  /// controlStateStep() followed by configInterface()
+  int configStepStandard(int step) {
+    if (step == 0) {
+      codec_cfg = begin_cfg;
+      state_step_from = -1;
+    }
+    if (state_step_from < 0) {
+      int rc = initStep(step, codec_cfg);
+      if (rc != STEP_DONE) return rc;
+      state_step_from = step;
+    }
+    codec_mode_t codec_mode = codec_cfg.get_mode();
+    int rc = controlStateStep(step - state_step_from, codec_mode);
+    if (rc == STEP_FAILED) AD_LOGE("AudioDriver controlState failed");
+    if (rc != STEP_DONE) return rc;
+    if (!configInterface(codec_mode, codec_cfg.i2s)) {
+      AD_LOGE("AudioDriver configInterface failed");
+      return STEP_FAILED;
+    }
+    return STEP_DONE;
+  }
+
+  /// Executes the due steps of the non-blocking begin or setConfig of
+  /// several drivers, so that their settle delays overlap: returns the delay
+  /// in ms until the next step is due, STEP_DONE or STEP_FAILED. nowMs is
+  /// the time of the poll(), so that a virtual clock is supported.
+  static int pollDrivers(AudioDriver** drivers, int n, uint32_t nowMs) {
+    int result = STEP_DONE;
+    for (int j = 0; j < n; j++) {
+      BeginState state = drivers[j]->poll(nowMs);
+      if (state == BeginState::Failed) return STEP_FAILED;
+      if (state != BeginState::Busy) continue;
+      int wait = drivers[j]->pollDelay(nowMs);
+      if (result == STEP_DONE || wait < result) result = wait;
+    }
+    return result;
+  }
+
+  /// Non-blocking init() used by beginStepStandard(): by default init() is
+  /// executed as a single step
+  virtual int initStep(int step, codec_config_t codec_cfg) {
+    return init(codec_cfg) ? STEP_DONE : STEP_FAILED;
+  }
+
+  /// Non-blocking controlState() used by configStepStandard(): by default
+  /// controlState() is executed as a single step
+  virtual int controlStateStep(int step, codec_mode_t mode) {
+    return controlState(mode) ? STEP_DONE : STEP_FAILED;
+  }
+
+  /// Fast path of setSampleRate(): reprograms only the clock registers.
+  /// Returns false if not supported, so that the codec is reinitialized.
+  virtual bool configSampleRate(samplerate_t rate) { return false; }
+
   virtual bool init(codec_config_t codec_cfg) { return false; }
   virtual bool deinit() { return false; }
   virtual bool controlState(codec_mode_t mode) { return false; };
@@ -400,18 +804,41 @@ class AudioDriverAC101Class : public AudioDriver {
   /// Provides access to the wrapped AC101 driver instance
   AC101& driver() { return ac101; }
 
+  bool resync() { return ac101.resync() == RESULT_OK; }
+
  protected:
   AC101 ac101;
 
+  bool saveDriverState(StateBlobWriter& out) {
+    return ac101.saveState(out) == RESULT_OK;
+  }
+  bool restoreDriverState(StateBlobReader& in) {
+    ac101.setWire(getI2C());
+    ac101.setAddress(getI2CAddress());
+    return ac101.restoreState(in) == RESULT_OK;
+  }
+
   bool init(codec_config_t codec_cfg) {
     ac101.setWire(getI2C());
     ac101.setAddress(getI2CAddress());
     return ac101.init(&codec_cfg) == RESULT_OK;
   }
+  int beginStep(int step) { return beginStepStandard(step); }
+  int configStep(int step) { return configStepStandard(step); }
+  int initStep(int step, codec_config_t codec_cfg) {
+    if (step == 0) {
+      ac101.setWire(getI2C());
+      ac101.setAddress(getI2CAddress());
+    }
+    return ac101.initStep(step, &codec_cfg);
+  }
   bool deinit() { return ac101.deinit() == RESULT_OK; }
   bool controlState(codec_mode_t mode) {
     return ac101.ctrlStateActive(mode, true) == RESULT_OK;
   }
+  int controlStateStep(int step, codec_mode_t mode) {
+    return ac101.ctrlStateStep(step, mode);
+  }
   bool configInterface(codec_mode_t mode, I2SDefinition iface) {
     return ac101.configI2S(mode, &iface) == RESULT_OK;
   }
@@ -647,28 +1074,26 @@ class AudioDriverCS42448Class : public AudioDriver {
     i2c_default_address = deviceAddr;
   }
   bool begin(CodecConfig codecCfg, DriverDeviceInfo& pins) override {
-    cfg = codecCfg;
+    codec_cfg = codecCfg;
+    p_pins = &pins;
     // setup pins
     pins.begin();
     // setup cs42448
-    cs42448.begin(cfg, getI2C(), getI2CAddress());
+    cs42448.begin(codec_cfg, getI2C(), getI2CAddress());
     cs42448.setMute(false);
     return true;
   }
   virtual bool setConfig(CodecConfig codecCfg) {
-    bool result = true;
-    if (codecCfg.equalsExRate(cfg)) {
+    if (codecCfg.equalsExRate(codec_cfg)) {
       // just update the rate
-      if (cfg.i2s.rate != codecCfg.getRateNumeric()) {
-        cs42448.setMute(true);
-        cs42448.setSampleRate(codecCfg.getRateNumeric());
-        cs42448.setMute(false);
+      if (codecCfg.i2s.rate == codec_cfg.i2s.rate) return true;
+      if (configSampleRate(codecCfg.i2s.rate)) {
+        codec_cfg = codecCfg;
+        return true;
       }
-    } else {
-      assert(p_pins != nullptr);
-      result = begin(codecCfg, *p_pins);
     }
-    return result;
+    assert(p_pins != nullptr);
+    return begin(codecCfg, *p_pins);
   }
   bool end(void) override { return cs42448.end(); }
   bool setMute(bool enable) override { return cs42448.setMute(enable); }
@@ -698,7 +1123,12 @@ class AudioDriverCS42448Class : public AudioDriver {
  protected:
   CS42448 cs42448;
   int volume = 100;
-  CodecConfig cfg;
+
+  bool configSampleRate(samplerate_t rate) override {
+    CodecConfig cfg = codec_cfg;
+    cfg.i2s.rate = rate;
+    return cs42448.changeSampleRate(cfg.getRateNumeric());
+  }
 };
 
 /**
@@ -721,15 +1151,39 @@ class AudioDriverES7210Class : public AudioDriver {
   bool isInputVolumeSupported() { return true; }
   ES7210& driver() { return es7210; }
 
+  bool resync() { return es7210.resync() == RESULT_OK; }
+  bool beginDeferred() {
+    es7210.beginDeferred();
+    return true;
+  }
+  bool flush() { return es7210.flush() == RESULT_OK; }
+
  protected:
   ES7210 es7210;
   int volume;
 
+  bool saveDriverState(StateBlobWriter& out) {
+    out.put8((uint8_t)volume);
+    return es7210.saveState(out) == RESULT_OK;
+  }
+  bool restoreDriverState(StateBlobReader& in) {
+    int vol = in.get8();
+    es7210.setWire(getI2C());
+    es7210.setAddress(getI2CAddress());
+    if (es7210.restoreState(in) != RESULT_OK) return false;
+    volume = vol;
+    return true;
+  }
+
   bool init(codec_config_t codec_cfg) {
     es7210.setWire(getI2C());
     es7210.setAddress(getI2CAddress());
     return es7210.init(&codec_cfg) == RESULT_OK;
   }
+  /// ADC only: no mute window needed
+  bool configSampleRate(samplerate_t rate) {
+    return es7210.configSample(rate) == RESULT_OK;
+  }
   bool deinit() { return es7210.deinit() == RESULT_OK; }
 
   bool controlState(codec_mode_t mode) {
@@ -975,10 +1429,26 @@ class AudioDriverES8311Class : public AudioDriver {
 
   ES8311& driver() { return es8311; }
 
+  bool resync() { return es8311.resync() == RESULT_OK; }
+  bool beginDeferred() {
+    es8311.beginDeferred();
+    return true;
+  }
+  bool flush() { return es8311.flush() == RESULT_OK; }
+
  protected:
   ES8311 es8311;
   int master_clock_source = -1;
 
+  bool saveDriverState(StateBlobWriter& out) {
+    return es8311.saveState(out) == RESULT_OK;
+  }
+  bool restoreDriverState(StateBlobReader& in) {
+    es8311.setWire(getI2C());
+    es8311.setAddress(getI2CAddress());
+    return es8311.restoreState(in) == RESULT_OK;
+  }
+
   bool init(codec_config_t codec_cfg) {
     int mclk_src = master_clock_source;
     if (mclk_src == -1) {
@@ -992,6 +1462,9 @@ class AudioDriverES8311Class : public AudioDriver {
     es8311.setMclkSrc(mclk_src);
     return es8311.init(&codec_cfg) == RESULT_OK;
   }
+  bool configSampleRate(samplerate_t rate) {
+    return es8311.changeSampleRate(rate) == RESULT_OK;
+  }
   bool deinit() { return es8311.deinit() == RESULT_OK; }
 
   bool controlState(codec_mode_t mode) {
@@ -1142,11 +1615,33 @@ class AudioDriverES8388Class : public AudioDriver {
   }
   int getVolumeHack() { return volume_hack; }
 
+  bool resync() { return es8388.resync() == RESULT_OK; }
+  bool beginDeferred() {
+    es8388.beginDeferred();
+    return true;
+  }
+  bool flush() { return es8388.flush() == RESULT_OK; }
+
  protected:
   ES8388 es8388;
   bool line_active[2] = {true, true};
   int volume_hack = AI_THINKER_ES8388_VOLUME_HACK;
 
+  bool saveDriverState(StateBlobWriter& out) {
+    out.put8(line_active[0] | (line_active[1] << 1));
+    return es8388.saveState(out) == RESULT_OK;
+  }
+  bool restoreDriverState(StateBlobReader& in) {
+    uint8_t active = in.get8();
+    es8388.setWire(getI2C());
+    es8388.setAddress(getI2CAddress());
+    if (es8388.restoreState(in) != RESULT_OK) return false;
+    line_active[0] = active & 1;
+    line_active[1] = (active & 2) != 0;
+    volume_hack = es8388.getVolumeHack();
+    return true;
+  }
+
   bool init(codec_config_t codec_cfg) {
     es8388.setWire(getI2C());
     es8388.setAddress(getI2CAddress());
@@ -1194,7 +1689,22 @@ class AudioDriverTAS5805MClass : public AudioDriver {
     tas5805m.setAddress(getI2CAddress());
     return tas5805m.init(&codec_cfg) == RESULT_OK;
   }
+  int beginStep(int step) { return beginStepStandard(step); }
+  int configStep(int step) { return configStepStandard(step); }
+  int initStep(int step, codec_config_t codec_cfg) {
+    if (step == 0) {
+      tas5805m.setWire(getI2C());
+      tas5805m.setAddress(getI2CAddress());
+    }
+    return tas5805m.initStep(step, &codec_cfg);
+  }
   bool deinit() { return tas5805m.deinit() == RESULT_OK; }
+  bool controlState(codec_mode_t mode) {
+    return tas5805m.ctrlStateActive(mode, true) == RESULT_OK;
+  }
+  bool configInterface(codec_mode_t mode, I2SDefinition iface) {
+    return tas5805m.configI2S(mode, &iface) == RESULT_OK;
+  }
 };
 
 /**
@@ -1213,6 +1723,7 @@ class AudioDriverWM8960Class : public AudioDriver {
 
   bool begin(CodecConfig codecCfg, DriverDeviceInfo& pins) {
     codec_cfg = codecCfg;
+    p_pins = &pins;
 
     // define wire object
     wm8960.setWire(getI2C());
@@ -1278,10 +1789,29 @@ class AudioDriverWM8960Class : public AudioDriver {
 
   void dumpRegisters() { wm8960.dump(); }
 
+  bool resync() { return wm8960.resync(); }
+
  protected:
   WM8960 wm8960;
   int volume_in = 100;
   int volume_out = 100;
+
+  bool saveDriverState(StateBlobWriter& out) {
+    out.put8((uint8_t)volume_in);
+    out.put8((uint8_t)volume_out);
+    return wm8960.saveState(out);
+  }
+  bool restoreDriverState(StateBlobReader& in) {
+    int vol_in = in.get8();
+    int vol_out = in.get8();
+    wm8960.setWire(getI2C());
+    wm8960.setAddress(getI2CAddress());
+    wm8960.setWriteRetryCount(i2c_retry_count);
+    if (!wm8960.restoreState(in)) return false;
+    volume_in = vol_in;
+    volume_out = vol_out;
+    return true;
+  }
   int i2c_retry_count = 0;
   uint32_t vs1053_mclk_hz = 0;
   bool vs1053_enable_pll = true;
@@ -1319,6 +1849,17 @@ class AudioDriverWM8960Class : public AudioDriver {
     return features;
   }
 
+  bool configSampleRate(samplerate_t rate) {
+    uint16_t ctr1 = 0;
+    if (!wm8960.read(WM8960_REG_CTR1, &ctr1)) return false;
+    codec_cfg.i2s.rate = rate;
+    // soft mute the DAC while the clocks change
+    bool result = wm8960.set(WM8960_REG_CTR1, WM8960_CTR1_DACMU_MUTE);
+    result &= configure_clocking();
+    result &= wm8960.write(WM8960_REG_CTR1, ctr1);
+    return result;
+  }
+
   bool configure_clocking() {
     if (vs1053_mclk_hz == 0) {
       // just pick a multiple of the sample rate
@@ -1692,34 +2233,12 @@ class AudioDriverLyratMiniClass : public AudioDriver {
  public:
   bool begin(CodecConfig codecCfg, DriverDeviceInfo& pins) {
     AD_LOGI("AudioDriverLyratMiniClass::begin");
-    p_pins = &pins;
-    codec_cfg = codecCfg;
-
-    // setup SPI for SD
-    // pins.setSPIActiveForSD(codecCfg.sd_active);
-
-    // Start ES8311
-    AD_LOGI("starting ES8311");
-    pins.begin();
-    dac.setPins(this->pins());
-    if (!dac.setConfig(codecCfg)) {
-      AD_LOGE("setConfig failed");
-      return false;
-    }
-    setPAPower(true);
-    setVolume(DRIVER_DEFAULT_VOLUME);
-
-    // Start ES7243
-    if (codecCfg.input_device != ADC_INPUT_NONE) {
-      AD_LOGI("starting ES7243");
-      adc.setPins(this->pins());
-      if (!adc.setConfig(codecCfg)) {
-        AD_LOGE("adc.begin failed");
-        return false;
-      }
-    }
-
-    return true;
+    begin_cfg = codecCfg;
+    p_begin_pins = &pins;
+    return run_steps([&](int step) {
+      begin_now_ms = uptimeMs();
+      return beginStep(step);
+    });
   }
   bool end(void) {
     int rc = 0;
@@ -1737,6 +2256,36 @@ class AudioDriverLyratMiniClass : public AudioDriver {
  protected:
   AudioDriverES8311Class dac;
   AudioDriverES7243Class adc;
+
+  /// Configures the ES8311 and the ES7243 in parallel
+  int beginStep(int step) override {
+    AudioDriver* drivers[] = {&dac, &adc};
+    bool has_adc = begin_cfg.input_device != ADC_INPUT_NONE;
+    if (step > 0) {
+      int rc = pollDrivers(drivers, has_adc ? 2 : 1, begin_now_ms);
+      if (rc == STEP_FAILED) AD_LOGE("ES8311 or ES7243 setConfig failed");
+      if (rc != STEP_DONE) return rc;
+      setPAPower(true);
+      setVolume(DRIVER_DEFAULT_VOLUME);
+      return STEP_DONE;
+    }
+    p_pins = p_begin_pins;
+    codec_cfg = begin_cfg;
+
+    // setup SPI for SD
+    // pins.setSPIActiveForSD(codecCfg.sd_active);
+
+    AD_LOGI("starting ES8311");
+    p_pins->begin();
+    dac.setPins(this->pins());
+    dac.setConfigAsync(codec_cfg);
+    if (has_adc) {
+      AD_LOGI("starting ES7243");
+      adc.setPins(this->pins());
+      adc.setConfigAsync(codec_cfg);
+    }
+    return 0;
+  }
 };
 
 /**
@@ -1751,38 +2300,12 @@ class AudioDriverCombined : public AudioDriver {
 
   bool begin(CodecConfig codecCfg, DriverDeviceInfo& pins) {
     AD_LOGI("AudioDriverCombined::begin");
-    p_pins = &pins;
-    codec_cfg = codecCfg;
-
-    assert(p_dac != nullptr);
-    assert(p_adc != nullptr);
-
-    AD_LOGI("sd_active: %d", codecCfg.sd_active);
-    p_pins->setSPIActiveForSD(codecCfg.sd_active);
-    AD_LOGI("sdmmc_active: %d", codecCfg.sdmmc_active);
-    p_pins->setSDMMCActive(codecCfg.sdmmc_active);
-
-    // Start
-    AD_LOGI("starting DAC");
-    pins.begin();
-    p_dac->setPins(this->pins());
-    if (!p_dac->setConfig(codecCfg)) {
-      AD_LOGE("setConfig failed");
-      return false;
-    }
-    setPAPower(true);
-    setVolume(DRIVER_DEFAULT_VOLUME);
-
-    // Start ADC
-    if (codecCfg.input_device != ADC_INPUT_NONE) {
-      AD_LOGI("starting ADC");
-      p_adc->setPins(this->pins());
-      if (!p_adc->setConfig(codecCfg)) {
-        AD_LOGE("adc.begin failed");
-        return false;
-      }
-    }
-    return true;
+    begin_cfg = codecCfg;
+    p_begin_pins = &pins;
+    return run_steps([&](int step) {
+      begin_now_ms = uptimeMs();
+      return beginStep(step);
+    });
   }
   bool end(void) {
     int rc = 0;
@@ -1800,6 +2323,41 @@ class AudioDriverCombined : public AudioDriver {
  protected:
   AudioDriver* p_dac = nullptr;
   AudioDriver* p_adc = nullptr;
+
+  /// Configures the DAC and the ADC in parallel: the settle delays overlap
+  int beginStep(int step) override {
+    AudioDriver* drivers[] = {p_dac, p_adc};
+    bool has_adc = begin_cfg.input_device != ADC_INPUT_NONE;
+    if (step > 0) {
+      int rc = pollDrivers(drivers, has_adc ? 2 : 1, begin_now_ms);
+      if (rc == STEP_FAILED) AD_LOGE("DAC or ADC setConfig failed");
+      if (rc != STEP_DONE) return rc;
+      setPAPower(true);
+      setVolume(DRIVER_DEFAULT_VOLUME);
+      return STEP_DONE;
+    }
+    p_pins = p_begin_pins;
+    codec_cfg = begin_cfg;
+
+    assert(p_dac != nullptr);
+    assert(p_adc != nullptr);
+
+    AD_LOGI("sd_active: %d", codec_cfg.sd_active);
+    p_pins->setSPIActiveForSD(codec_cfg.sd_active);
+    AD_LOGI("sdmmc_active: %d", codec_cfg.sdmmc_active);
+    p_pins->setSDMMCActive(codec_cfg.sdmmc_active);
+
+    AD_LOGI("starting DAC");
+    p_pins->begin();
+    p_dac->setPins(this->pins());
+    p_dac->setConfigAsync(codec_cfg);
+    if (has_adc) {
+      AD_LOGI("starting ADC");
+      p_adc->setPins(this->pins());
+      p_adc->setConfigAsync(codec_cfg);
+    }
+    return 0;
+  }
 };
 
 /**
@@ -1885,39 +2443,9 @@ class AudioDriverNAU8325Class : public AudioDriver {
 
   bool begin(CodecConfig cfg, DriverDeviceInfo& pins) override {
     AD_LOGI("AudioDriverNAU8325Class::begin");
-
-    this->p_pins = &pins;
-
-    // Get I2C config
-    auto i2c_opt = pins.getI2CPins(PinFunction::CODEC);
-    if (!i2c_opt) {
-      AD_LOGE("No I2C pins defined for codec");
-      return false;
-    }
-    InfoI2C val = i2c_opt.value();
-
-    // Create instance with required params (only TwoWire&)
-    nau8325 = new NAU8325(val.p_wire);
-
-    // Set MCLK if available
-    auto mclk = pins.getPinID(PinFunction::MCLK_SOURCE);
-    if (mclk != GPIO_UNDEFINED) {
-      getGPIO().pinMode(mclk, OUTPUT);
-      getGPIO().digitalWrite(mclk, HIGH);
-      delayMs(10);  // optional small delay to stabilize
-    }
-
-    // Begin your driver using known public methods
-    int fs = cfg.getRateNumeric();
-    int bits = cfg.getBitsNumeric();
-
-    AD_LOGI("Calling nau8325->begin(fs=%d, bits=%d)", fs, bits);
-    if (!nau8325->begin(fs, bits)) {
-      AD_LOGE("NAU8325 begin failed");
-      return false;
-    }
-
-    return true;
+    begin_cfg = cfg;
+    p_begin_pins = &pins;
+    return run_steps([&](int step) { return beginStep(step); });
   }
 
   bool end() override {
@@ -1945,6 +2473,45 @@ class AudioDriverNAU8325Class : public AudioDriver {
     // NAU8325 doesn't have a getVolume, so return last set or dummy
     return 100;
   }
+
+ protected:
+  int beginStep(int step) override {
+    if (step > 0) {
+      // Begin your driver using known public methods
+      int fs = begin_cfg.getRateNumeric();
+      int bits = begin_cfg.getBitsNumeric();
+      if (step == 1) {
+        AD_LOGI("Calling nau8325->begin(fs=%d, bits=%d)", fs, bits);
+      }
+      int rc = nau8325->beginStep(step - 1, fs, bits, 256);
+      if (rc == STEP_FAILED) AD_LOGE("NAU8325 begin failed");
+      return rc;
+    }
+
+    DriverDeviceInfo& pins = *p_begin_pins;
+    this->p_pins = &pins;
+
+    // Get I2C config
+    auto i2c_opt = pins.getI2CPins(PinFunction::CODEC);
+    if (!i2c_opt) {
+      AD_LOGE("No I2C pins defined for codec");
+      return STEP_FAILED;
+    }
+    InfoI2C val = i2c_opt.value();
+
+    // Create instance with required params (only TwoWire&)
+    if (nau8325) delete nau8325;
+    nau8325 = new NAU8325(val.p_wire);
+
+    // Set MCLK if available
+    auto mclk = pins.getPinID(PinFunction::MCLK_SOURCE);
+    if (mclk != GPIO_UNDEFINED) {
+      getGPIO().pinMode(mclk, OUTPUT);
+      getGPIO().digitalWrite(mclk, HIGH);
+      return 10;  // optional small delay to stabilize
+    }
+    return 0;
+  }
 };
 
 #ifdef ARDUINO
@@ -1958,25 +2525,9 @@ class AudioDriverNAU8325Class : public AudioDriver {
 class AudioDriverAD1938Class : public AudioDriver {
  public:
   bool begin(CodecConfig codecCfg, DriverDeviceInfo& pins) override {
-    int clatch = pins.getPinID(PinFunction::LATCH);
-    if (clatch < 0) return false;
-    int reset = pins.getPinID(PinFunction::RESET);
-    if (reset < 0) return false;
-    auto spi_opt = pins.getSPIPins(PinFunction::CODEC);
-    SPIClass* p_spi = nullptr;
-    if (spi_opt) {
-      p_spi = (SPIClass*)spi_opt.value().p_spi;
-    } else {
-      p_spi = &SPI;
-      p_spi->begin();
-    }
-    // setup pins
-    pins.begin();
-    // setup ad1938
-    ad1938.begin(getGPIO(), codecCfg, clatch, reset, *p_spi);
-    ad1938.enable();
-    ad1938.setMute(false);
-    return true;
+    begin_cfg = codecCfg;
+    p_begin_pins = &pins;
+    return run_steps([&](int step) { return beginStep(step); });
   }
   virtual bool setConfig(CodecConfig codecCfg) {
     assert(p_pins != nullptr);
@@ -2020,6 +2571,37 @@ class AudioDriverAD1938Class : public AudioDriver {
   AD1938 ad1938;
   int volume = 100;
   int volumes[8] = {100, 100, 100, 100, 100, 100, 100, 100};
+  int clatch_pin = -1;
+  int reset_pin = -1;
+  SPIClass* p_spi = nullptr;
+
+  int beginStep(int step) override {
+    if (step > 0) {
+      // setup ad1938
+      int rc = ad1938.beginStep(step - 1, getGPIO(), begin_cfg, clatch_pin,
+                                reset_pin, *p_spi);
+      if (rc != STEP_DONE) return rc;
+      ad1938.enable();
+      ad1938.setMute(false);
+      return STEP_DONE;
+    }
+    DriverDeviceInfo& pins = *p_begin_pins;
+    p_pins = &pins;
+    clatch_pin = pins.getPinID(PinFunction::LATCH);
+    if (clatch_pin < 0) return STEP_FAILED;
+    reset_pin = pins.getPinID(PinFunction::RESET);
+    if (reset_pin < 0) return STEP_FAILED;
+    auto spi_opt = pins.getSPIPins(PinFunction::CODEC);
+    if (spi_opt) {
+      p_spi = (SPIClass*)spi_opt.value().p_spi;
+    } else {
+      p_spi = &SPI;
+      p_spi->begin();
+    }
+    // setup pins
+    pins.begin();
+    return 0;
+  }
 };
 
 #endif
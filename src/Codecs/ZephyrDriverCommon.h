@@ -105,6 +105,7 @@ class ZephyrDriverCommon {
   /// Read-Modify-Write of a single byte register
   bool updateReg(uint8_t reg, uint8_t mask, uint8_t value) {
     uint8_t old = 0;
+    I2CTransaction transaction(wire);
     if (!readReg(reg, old)) return false;
     uint8_t updated = (old & ~mask) | (value & mask);
     if (updated == old) return true;
@@ -131,6 +132,7 @@ class ZephyrDriverCommon {
   /// Read-Modify-Write of a 16 bit (big endian) register
   bool updateReg16(uint8_t reg, uint16_t mask, uint16_t value) {
     uint16_t old = 0;
+    I2CTransaction transaction(wire);
     if (!readReg16(reg, old)) return false;
     uint16_t updated = (old & ~mask) | (value & mask);
     if (updated == old) return true;
@@ -6,6 +6,8 @@
 #include "Codecs/CodecConstants.h"
 #include "DriverCommon.h"
 #include "Platforms/API_I2C.h"
+#include "Platforms/RegMap.h"
+#include "Platforms/RegScript.h"
 #include "stdbool.h"
 #include <string.h>
 
@@ -167,6 +169,7 @@ class AC101 {
   static constexpr uint8_t AC_DAC_DAPLGOPA = 0xb0;
   static constexpr uint8_t AC_DAC_DAPOPT = 0xb1;
   static constexpr uint8_t DAC_DAP_ENA = 0xb5;
+  static constexpr int AC101_REG_COUNT = 0xb6;
   AC101() = default;
 
   /// Defines the I2C bus instance to be used
@@ -178,85 +181,66 @@ class AC101 {
   }
 
   error_t init(codec_config_t* codec_cfg) {
-    error_t res = RESULT_OK;
-
-    res = writeReg(CHIP_AUDIO_RS, 0x123);
-    delayMs(1000);
-    if (res != RESULT_OK) {
-      AD_LOGE("reset failed!");
-      return res;
-    } else {
-      AD_LOGI("reset");
+    bool ok = run_steps([&](int step) { return initStep(step, codec_cfg); });
+    return ok ? RESULT_OK : RESULT_FAIL;
+  }
+
+  /// Non-blocking init(): executes the indicated step and returns the delay
+  /// in ms before the next step, STEP_DONE or STEP_FAILED
+  int initStep(int step, codec_config_t* codec_cfg) {
+    switch (step) {
+      case 0:
+        if (reset() != RESULT_OK) {
+          AD_LOGE("reset failed!");
+          return STEP_FAILED;
+        }
+        AD_LOGI("reset");
+        return 1000;
+      default: {
+        const uint16_t args[] = {getSrcValue(codec_cfg->input_device)};
+        if (runScript(initScript(), args) != RESULT_OK) return STEP_FAILED;
+        AD_LOGI("init done");
+        return STEP_DONE;
+      }
     }
-    res |= writeReg(SPKOUT_CTRL, 0xe880);
-
-    // Enable the PLL from 256*44.1KHz MCLK source
-    res |= writeReg(PLL_CTRL1, 0x014f);
-    // res |= writeReg(PLL_CTRL2, 0x83c0);
-    res |= writeReg(PLL_CTRL2, 0x8600);
-
-    // Clocking system
-    res |= writeReg(SYSCLK_CTRL, 0x8b08);
-    res |= writeReg(MOD_CLK_ENA, 0x800c);
-    res |= writeReg(MOD_RST_CTRL, 0x800c);
-    res |= writeReg(I2S_SR_CTRL, 0x7000);  // sample rate
-    // AIF config
-    res |= writeReg(I2S1LCK_CTRL, 0x8850);     // BCLK/LRCK
-    res |= writeReg(I2S1_SDOUT_CTRL, 0xc000);  //
-    res |= writeReg(I2S1_SDIN_CTRL, 0xc000);
-    res |= writeReg(I2S1_MXR_SRC, 0x2200);  //
-
-    res |= writeReg(ADC_SRCBST_CTRL, 0xccc4);
-
-    res |= writeReg(ADC_SRC, getSrcValue(codec_cfg->input_device));
-    res |= writeReg(ADC_DIG_CTRL, 0x8000);
-    res |= writeReg(ADC_APC_CTRL, 0xbbc3);
-
-    // Path Configuration
-    res |= writeReg(DAC_MXR_SRC, 0xcc00);
-    res |= writeReg(DAC_DIG_CTRL, 0x8000);
-    res |= writeReg(OMIXER_SR, 0x0081);
-    res |= writeReg(OMIXER_DACA_CTRL, 0xf080);  //}
-
-    //* Enable Speaker output
-    res |= writeReg(0x58, 0xeabd);
-
-    AD_LOGI("init done");
-    return res;
   }
 
-  error_t deinit() {
-    return writeReg(CHIP_AUDIO_RS, 0x123);  // soft reset
+  error_t deinit() { return reset(); }
+
+  /// Soft reset: all registers are back to their defaults
+  error_t reset() {
+    error_t rc = regs.writeForced(CHIP_AUDIO_RS, 0x123);
+    regs.invalidate();
+    return rc;
+  }
+
+  /// Restores the configuration after a reset or power cycle of the chip
+  /// w/o running the full init: only the known registers are written
+  error_t resync() {
+    I2CTransaction transaction(i2c_handle);
+    return regs.resync();
+  }
+
+  /// Serialises the register cache (see AudioDriver::saveState())
+  error_t saveState(StateBlobWriter& out) { return regs.save(out); }
+
+  /// Restores a state created by saveState() on a chip in its power-on state
+  /// w/o running the full init
+  error_t restoreState(StateBlobReader& in) {
+    if (regs.load(in) != RESULT_OK) return RESULT_FAIL;
+    return resync();
   }
 
   error_t ctrlStateActive(codec_mode_t mode, bool ctrlStateActive) {
-    int res = 0;
-    int es_mode_t = 0;
+    if (!ctrlStateActive) return stop(getModule(mode));
+    return start(getModule(mode));
+  }
 
-    switch (mode) {
-      case CODEC_MODE_ENCODE:
-        es_mode_t = AC_MODULE_ADC;
-        break;
-      case CODEC_MODE_LINE_IN:
-        es_mode_t = AC_MODULE_LINE;
-        break;
-      case CODEC_MODE_DECODE:
-        es_mode_t = AC_MODULE_DAC;
-        break;
-      case CODEC_MODE_BOTH:
-        es_mode_t = AC_MODULE_ADC_DAC;
-        break;
-      default:
-        es_mode_t = AC_MODULE_DAC;
-        AD_LOGW("Codec mode not support, default is decode mode");
-        break;
-    }
-    if (!ctrlStateActive) {
-      res = stop((ac_module_t)es_mode_t);
-    } else {
-      res = start((ac_module_t)es_mode_t);
-    }
-    return res;
+  /// Non-blocking ctrlStateActive(mode, true): executes the indicated step
+  /// and returns the delay in ms before the next step, STEP_DONE or
+  /// STEP_FAILED
+  int ctrlStateStep(int step, codec_mode_t mode) {
+    return startStep(step, getModule(mode));
   }
 
   error_t configI2S(codec_mode_t mode, I2SDefinition* iface) {
@@ -438,13 +422,16 @@ class AC101 {
     *volume = getEarphVolume();
     return 0;
   }
+  /// Writes the register: unchanged values are not sent again
   error_t writeReg(uint8_t reg_add, uint16_t data) {
-    uint8_t send_buff[2];
-    send_buff[0] = (data >> 8) & 0xff;
-    send_buff[1] = data & 0xff;
-    return i2c_bus_write_bytes(i2c_handle, i2c_addr, &reg_add,
-                                sizeof(reg_add), (uint8_t*)send_buff,
-                                sizeof(send_buff));
+    return regs.write(reg_add, data);
+  }
+
+  /// Writes a list of 16 bit registers in one batch
+  error_t writeRegs(const RegWrite* list, int n) {
+    error_t rc = i2c_bus_write_batch(i2c_handle, i2c_addr, list, n, 1, 2);
+    regs.set(list, n, rc);
+    return rc;
   }
 
   error_t readI2C(uint8_t devAddr, uint8_t reg_add, uint8_t* p_data,
@@ -453,11 +440,10 @@ class AC101 {
                                p_data, size);
   }
 
+  /// Provides the register value from the cache or the chip
   uint16_t readReg(uint8_t reg_addr) {
     uint16_t val = 0;
-    uint8_t data_rd[2];
-    readI2C(i2c_addr, reg_addr, data_rd, 2);
-    val = (data_rd[0] << 8) + data_rd[1];
+    regs.read(reg_addr, &val);
     return val;
   }
 
@@ -520,36 +506,46 @@ class AC101 {
   }
 
   error_t start(ac_module_t mode) {
+    bool ok = run_steps([&](int step) { return startStep(step, mode); });
+    return ok ? RESULT_OK : RESULT_FAIL;
+  }
+
+  /// Non-blocking start(): executes the indicated step and returns the delay
+  /// in ms before the next step, STEP_DONE or STEP_FAILED
+  int startStep(int step, ac_module_t mode) {
+    bool dac = mode == AC_MODULE_DAC || mode == AC_MODULE_ADC_DAC ||
+               mode == AC_MODULE_LINE;
     error_t res = 0;
-    if (mode == AC_MODULE_LINE) {
-      res |= writeReg(0x51, 0x0408);
-      res |= writeReg(0x40, 0x8000);
-      res |= writeReg(0x50, 0x3bc0);
-    }
-    if (mode == AC_MODULE_ADC || mode == AC_MODULE_ADC_DAC ||
-        mode == AC_MODULE_LINE) {
-      // I2S1_SDOUT_CTRL
-      // res |= writeReg(PLL_CTRL2, 0x8120);
-      res |= writeReg(0x04, 0x800c);
-      res |= writeReg(0x05, 0x800c);
-      // res |= writeReg(0x06, 0x3000);
-    }
-    if (mode == AC_MODULE_DAC || mode == AC_MODULE_ADC_DAC ||
-        mode == AC_MODULE_LINE) {
-      //* Enable Headphoe output
-      res |= writeReg(OMIXER_DACA_CTRL, 0xff80);
-      res |= writeReg(HPOUT_CTRL, 0xc3c1);
-      res |= writeReg(HPOUT_CTRL, 0xcb00);
-      delayMs(100);
-      res |= writeReg(HPOUT_CTRL, 0xfbc0);
-
-      //* Enable Speaker output
-      res |= writeReg(SPKOUT_CTRL, 0xeabd);
-      delayMs(10);
-      setVoiceVolume(30);
+    switch (step) {
+      case 0:
+        if (mode == AC_MODULE_LINE) {
+          res |= writeReg(0x51, 0x0408);
+          res |= writeReg(0x40, 0x8000);
+          res |= writeReg(0x50, 0x3bc0);
+        }
+        if (mode == AC_MODULE_ADC || mode == AC_MODULE_ADC_DAC ||
+            mode == AC_MODULE_LINE) {
+          // I2S1_SDOUT_CTRL
+          // res |= writeReg(PLL_CTRL2, 0x8120);
+          res |= writeReg(0x04, 0x800c);
+          res |= writeReg(0x05, 0x800c);
+          // res |= writeReg(0x06, 0x3000);
+        }
+        if (!dac) return res == RESULT_OK ? STEP_DONE : STEP_FAILED;
+        //* Enable Headphoe output
+        res |= writeReg(OMIXER_DACA_CTRL, 0xff80);
+        res |= writeReg(HPOUT_CTRL, 0xc3c1);
+        res |= writeReg(HPOUT_CTRL, 0xcb00);
+        return res == RESULT_OK ? 100 : STEP_FAILED;
+      case 1:
+        res |= writeReg(HPOUT_CTRL, 0xfbc0);
+        //* Enable Speaker output
+        res |= writeReg(SPKOUT_CTRL, 0xeabd);
+        return res == RESULT_OK ? 10 : STEP_FAILED;
+      default:
+        setVoiceVolume(30);
+        return STEP_DONE;
     }
-
-    return res;
   }
 
   error_t stop(ac_module_t mode) {
@@ -560,8 +556,103 @@ class AC101 {
   }
 
  protected:
+  static ac_module_t getModule(codec_mode_t mode) {
+    switch (mode) {
+      case CODEC_MODE_ENCODE:
+        return AC_MODULE_ADC;
+      case CODEC_MODE_LINE_IN:
+        return AC_MODULE_LINE;
+      case CODEC_MODE_DECODE:
+        return AC_MODULE_DAC;
+      case CODEC_MODE_BOTH:
+        return AC_MODULE_ADC_DAC;
+      default:
+        AD_LOGW("Codec mode not support, default is decode mode");
+        return AC_MODULE_DAC;
+    }
+  }
+
   i2c_bus_handle_t i2c_handle = nullptr;
   int i2c_addr = AC101_ADDR;
+  /// registers that must not be cached
+  struct RegInfo {
+    static uint8_t flags(size_t reg) {
+      static constexpr RegDesc reg_desc[] = {
+          {CHIP_AUDIO_RS, REG_VOLATILE},  // write: soft reset, read: chip id
+          {HMIC_STATUS, REG_VOLATILE},
+      };
+      static_assert(reg_desc_valid(reg_desc, AC101_REG_COUNT),
+                    "AC101 reg_desc");
+      return reg_desc_flags(reg_desc, reg);
+    }
+  };
+  /// shadow copy of the 16 bit registers
+  RegMap<uint8_t, uint16_t, AC101_REG_COUNT, RegInfo> regs{
+      this, busWrite, busRead, busWriteBatch};
+
+  /// clocks, AIF and paths: args[0] is the ADC_SRC input selection
+  static const RegStep* initScript() {
+    static constexpr RegStep script[] = {
+        script_write(SPKOUT_CTRL, 0xe880),
+        // Enable the PLL from 256*44.1KHz MCLK source
+        script_write(PLL_CTRL1, 0x014f),
+        // script_write(PLL_CTRL2, 0x83c0),
+        script_write(PLL_CTRL2, 0x8600),
+        // Clocking system
+        script_write(SYSCLK_CTRL, 0x8b08),
+        script_write(MOD_CLK_ENA, 0x800c),
+        script_write(MOD_RST_CTRL, 0x800c),
+        script_write(I2S_SR_CTRL, 0x7000),  // sample rate
+        // AIF config
+        script_write(I2S1LCK_CTRL, 0x8850),  // BCLK/LRCK
+        script_write(I2S1_SDOUT_CTRL, 0xc000),
+        script_write(I2S1_SDIN_CTRL, 0xc000),
+        script_write(I2S1_MXR_SRC, 0x2200),
+        script_write(ADC_SRCBST_CTRL, 0xccc4),
+        script_write_arg(ADC_SRC, 0),
+        script_write(ADC_DIG_CTRL, 0x8000),
+        script_write(ADC_APC_CTRL, 0xbbc3),
+        // Path Configuration
+        script_write(DAC_MXR_SRC, 0xcc00),
+        script_write(DAC_DIG_CTRL, 0x8000),
+        script_write(OMIXER_SR, 0x0081),
+        script_write(OMIXER_DACA_CTRL, 0xf080),
+        //* Enable Speaker output
+        script_write(0x58, 0xeabd),
+        script_end(),
+    };
+    static_assert(reg_script_valid(script, AC101_REG_COUNT, 2, 1),
+                  "AC101 initScript()");
+    return script;
+  }
+
+  /// Executes the register script via the register cache
+  error_t runScript(const RegStep* script, const uint16_t* args = nullptr) {
+    return reg_script_run(reg_script_bus(regs), script, args);
+  }
+
+  static error_t busWrite(void* ref, uint8_t reg, uint16_t value) {
+    AC101* self = (AC101*)ref;
+    uint8_t send_buff[2];
+    send_buff[0] = (value >> 8) & 0xff;
+    send_buff[1] = value & 0xff;
+    return i2c_bus_write_bytes(self->i2c_handle, self->i2c_addr, &reg, 1,
+                               send_buff, sizeof(send_buff));
+  }
+
+  static error_t busRead(void* ref, uint8_t reg, uint16_t* value) {
+    AC101* self = (AC101*)ref;
+    uint8_t data_rd[2] = {0};
+    error_t rc = self->readI2C(self->i2c_addr, reg, data_rd, 2);
+    *value = (data_rd[0] << 8) + data_rd[1];
+    return rc;
+  }
+
+  static error_t busWriteBatch(void* ref, const RegWrite* list, int n) {
+    AC101* self = (AC101*)ref;
+    return i2c_bus_write_batch(self->i2c_handle, self->i2c_addr, list, n, 1,
+                               2);
+  }
 };
 
 }  // namespace audio_driver
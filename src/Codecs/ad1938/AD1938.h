@@ -28,6 +28,7 @@
 
 #include "Codecs/CodecConstants.h"
 #include "DriverCommon.h"
+#include "Platforms/API_Delay.h"
 #include "Platforms/API_GPIO.h"
 
 /*
@@ -221,6 +222,12 @@ class AD1938 {
   bool begin(API_GPIO& gpio, codec_config_t cfg, int clatchPin, int resetPin,
              SPIClass& spi = SPI);
 
+  /// Non-blocking begin(): executes the indicated step and returns the delay
+  /// in ms before the next step or STEP_DONE. The parameters are taken over
+  /// in step 0.
+  int beginStep(int step, API_GPIO& gpio, codec_config_t cfg, int clatchPin,
+                int resetPin, SPIClass& spi = SPI);
+
   bool end() {
     setMute(true);
     return disable();
@@ -281,26 +288,37 @@ class AD1938 {
 
 inline bool AD1938::begin(API_GPIO& gpio, codec_config_t configVal,
                           int clatchPin, int resetPin, SPIClass& spi) {
-  ad1938_clatch_pin = clatchPin;
-  ad1938_reset_pin = resetPin;
-  cfg = configVal;
-  p_spi = &spi;
-  p_gpio = &gpio;
-
-  // setup pins
-  p_gpio->pinMode(ad1938_clatch_pin, OUTPUT);
-  p_gpio->pinMode(ad1938_reset_pin, OUTPUT);
-
-  // reset codec
-  p_gpio->digitalWrite(ad1938_reset_pin, LOW);
-  delayMs(200);
-  p_gpio->digitalWrite(ad1938_reset_pin, HIGH);
-  delayMs(400);  // wait for 300ms to load the code
-
-  // setup basic information from codec_config_t
-  config();
+  return run_steps([&](int step) {
+    return beginStep(step, gpio, configVal, clatchPin, resetPin, spi);
+  });
+}
 
-  return true;
+inline int AD1938::beginStep(int step, API_GPIO& gpio,
+                             codec_config_t configVal, int clatchPin,
+                             int resetPin, SPIClass& spi) {
+  switch (step) {
+    case 0:
+      ad1938_clatch_pin = clatchPin;
+      ad1938_reset_pin = resetPin;
+      cfg = configVal;
+      p_spi = &spi;
+      p_gpio = &gpio;
+
+      // setup pins
+      p_gpio->pinMode(ad1938_clatch_pin, OUTPUT);
+      p_gpio->pinMode(ad1938_reset_pin, OUTPUT);
+
+      // reset codec
+      p_gpio->digitalWrite(ad1938_reset_pin, LOW);
+      return 200;
+    case 1:
+      p_gpio->digitalWrite(ad1938_reset_pin, HIGH);
+      return 400;  // wait for 300ms to load the code
+    default:
+      // setup basic information from codec_config_t
+      config();
+      return STEP_DONE;
+  }
 }
 
 inline unsigned char AD1938::spi_read_reg(unsigned char reg) {
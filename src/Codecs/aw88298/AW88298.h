@@ -73,6 +73,10 @@ class AW88298 : public ZephyrDriverCommon {
 
   /// Magic value written to REG_ID to trigger a software reset
   static constexpr uint16_t ID_SOFTRESET = 0x55AA;
+  /// Value of REG_ID
+  static constexpr uint16_t CHIP_ID = 0x1852;
+  /// Upper limit for the software reset (was a fixed delay)
+  static constexpr uint32_t RESET_TIMEOUT_MS = 50;
 
   static constexpr int VOLUME_DB_MAX = 0;
   static constexpr int VOLUME_DB_MIN = -96;
@@ -108,7 +112,6 @@ class AW88298 : public ZephyrDriverCommon {
     bool rc = true;
 
     rc &= softReset();
-    delayMs(50);
 
     // Power up: clear AMPPD and PWDN
     rc &= updateReg16(REG_SYSCTRL, SYSCTRL_AMPPD | SYSCTRL_PWDN, 0);
@@ -120,8 +123,21 @@ class AW88298 : public ZephyrDriverCommon {
     return rc;
   }
 
-  /// Trigger a software reset via REG_ID
-  bool softReset() { return updateReg16(REG_ID, 0xFFFF, ID_SOFTRESET); }
+  /// Trigger a software reset via REG_ID and wait until the chip reports its
+  /// ID again (the reset itself takes 1 ms)
+  bool softReset() {
+    if (!updateReg16(REG_ID, 0xFFFF, ID_SOFTRESET)) return false;
+    delayMs(1);
+    if (!wait_until(
+            [&]() {
+              uint16_t id = 0;
+              return readReg16(REG_ID, id) && id == CHIP_ID;
+            },
+            RESET_TIMEOUT_MS)) {
+      AD_LOGW("AW88298: reset timeout");
+    }
+    return true;
+  }
 
   /**
    * @brief Configure the digital audio interface: protocol mode, word
@@ -27,6 +27,8 @@
 #include "Codecs/CodecConstants.h"
 #include "DriverCommon.h"
 #include "Platforms/API_I2C.h"
+#include "Platforms/I2CBurstWriter.h"
+#include "Platforms/RegMap.h"
 
 namespace audio_driver {
 
@@ -64,6 +66,7 @@ class CS42448 {
   static constexpr uint8_t CS42448_Status = 0x19;
   static constexpr uint8_t CS42448_Status_Mask = 0x1A;
   static constexpr uint8_t CS42448_MUTEC_Pin_Control = 0x1B;
+  static constexpr int CS42448_REG_COUNT = 0x1C;
   static constexpr uint8_t CS42448_PDN = (1 << 0);
   static constexpr uint8_t CS42448_PDN_DAC1 = (1 << 1);
   static constexpr uint8_t CS42448_PDN_DAC2 = (1 << 2);
@@ -78,6 +81,10 @@ class CS42448 {
   static constexpr uint8_t CS42448_ADC_DIF_I2S = (1 << 0);
   static constexpr uint8_t CS42448_DAC_DIF_TDM = (3 << 4);
   static constexpr uint8_t CS42448_ADC_DIF_TDM = (3 << 1);
+  /// Auto increment needs the MAP INCR bit in the register address
+  static constexpr I2CBurstTrait burstTrait() {
+    return I2CBurstTrait(true, 0x80, I2C_MAX_BURST);
+  }
 
   enum class Format {
     LeftJustified24Bit = 0,
@@ -226,6 +233,17 @@ class CS42448 {
 
     return true;
   }
+  /// Changes only the sample rate: the DACs are muted while the functional
+  /// mode is reprogrammed
+  bool changeSampleRate(int rate) {
+    uint8_t mute_reg_value = 0;
+    if (!readReg(CS42448_DAC_Channel_Mute, &mute_reg_value)) return false;
+    if (!writeReg(CS42448_DAC_Channel_Mute, 0xFF)) return false;
+    bool result = setSampleRate(rate);
+    result &= writeReg(CS42448_DAC_Channel_Mute, mute_reg_value);
+    return result;
+  }
+
   // line starts at 0
   bool setMuteDAC(uint8_t line, bool mute) {
     uint8_t mute_reg_value;
@@ -256,11 +274,13 @@ class CS42448 {
 
   bool setVolumeDAC(uint8_t vol) {
     freeze(true);
+    I2CBurstWriter writer(i2c, i2c_address, burstTrait());
     for (uint8_t j = 0; j < 8; j++) {
-      setVolumeDAC(j, vol);
+      writer.write(CS42448_AOUT1_Volume_Control + j, vol);
     }
+    bool rc = writer.flush() == RESULT_OK;
     freeze(false);
-    return true;
+    return rc;
   }
 
   /// Sets signal levels in 0.5 dB increment from 0 dB to -127.5 dB; Value range
@@ -281,11 +301,13 @@ class CS42448 {
   /// Set volume in 0.5 dB increments. -128 .. 127 is -64dB .. 24dB; 0 = 0dB
   bool setVolumeADC(int8_t volume) {
     freeze(true);
+    I2CBurstWriter writer(i2c, i2c_address, burstTrait());
     for (uint8_t j = 0; j < 6; j++) {
-      setVolumeADC(j, volume);
+      writer.write(CS42448_AIN1_Volume_Control + j, volume);
     }
+    bool rc = writer.flush() == RESULT_OK;
     freeze(false);
-    return true;
+    return rc;
   }
 
   bool setVolumeADC(uint8_t channel, int8_t volume) {
@@ -542,7 +564,29 @@ class CS42448 {
     return result & 0xF;
   }
 
+  /// Logs all registers: the status register is skipped because reading
+  /// clears the interrupt flags
+  void readAll() {
+    for (int reg = CS42448_Chip_ID; reg < CS42448_REG_COUNT; reg++) {
+      if (RegInfo::flags(reg) & (REG_WRITE_ONLY | REG_PRECIOUS)) continue;
+      uint8_t value = 0;
+      readReg(reg, &value);
+      AD_LOGI("REG:%02x, %02x", reg, value);
+    }
+  }
+
  protected:
+  struct RegInfo {
+    static uint8_t flags(size_t reg) {
+      static constexpr RegDesc reg_desc[] = {
+          {CS42448_Chip_ID, REG_READ_ONLY},
+          {CS42448_Status, REG_VOLATILE | REG_READ_ONLY | REG_PRECIOUS},
+      };
+      static_assert(reg_desc_valid(reg_desc, CS42448_REG_COUNT),
+                    "CS42448 reg_desc");
+      return reg_desc_flags(reg_desc, reg);
+    }
+  };
   codec_config_t codec_config;
   i2c_bus_handle_t i2c;
   int i2c_address = 0x48;
@@ -576,6 +620,7 @@ class CS42448 {
   bool writeReg(uint8_t reg, uint8_t value) { return writeReg(reg, &value, 1); }
 
   bool writeReg(uint8_t reg, uint8_t* value, int len) {
+    if (len > 1) reg |= burstTrait().incr_flag;
     return i2c_bus_write_bytes(i2c, i2c_address, &reg, 1, value, len) ==
            RESULT_OK;
   }
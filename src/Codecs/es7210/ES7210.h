@@ -31,6 +31,7 @@
 #include "Codecs/CodecConstants.h"
 #include "DriverCommon.h"
 #include "Platforms/API_I2C.h"
+#include "Platforms/RegMap.h"
 #include "stdbool.h"
 
 
@@ -188,6 +189,10 @@ class ES7210 {
   static constexpr uint8_t ES7210_MIC4_POWER_REG4A = 0x4A;
   static constexpr uint8_t ES7210_MIC12_POWER_REG4B = 0x4B;
   static constexpr uint8_t ES7210_MIC34_POWER_REG4C = 0x4C;
+  static constexpr uint8_t ES7210_CHIP_ID1_REG3D = 0x3D;
+  static constexpr uint8_t ES7210_CHIP_ID0_REG3E = 0x3E;
+  static constexpr uint8_t ES7210_CHIP_VER_REG3F = 0x3F;
+  static constexpr int ES7210_REG_COUNT = 0x4F;
   static constexpr int I2S_DSP_MODE = 0;
   static constexpr int MCLK_DIV_FRE = 256;
   static constexpr const char* TAG_ES7210 = "ES7210";
@@ -208,7 +213,9 @@ class ES7210 {
     // select microphones
     error_t ret = setMicsForChannels(codec_cfg->i2s.channels);
 
-    ret |= writeReg(ES7210_RESET_REG00, 0xff);
+    ret |= regs.writeForced(ES7210_RESET_REG00, 0xff);
+    // the reset restores the register defaults
+    regs.invalidate();
     ret |= writeReg(ES7210_RESET_REG00, 0x41);
     ret |= writeReg(ES7210_CLOCK_OFF_REG01, 0x1f);
     ret |= writeReg(ES7210_TIME_CONTROL0_REG09,
@@ -407,29 +414,61 @@ class ES7210 {
 
   /// @brief Read all regs of ES7210
   void readAll(void) {
-    for (int i = 0; i <= 0x4E; i++) {
-      uint8_t reg = readReg(i);
-      AD_LOGI("REG:%02x, %02x", reg, i);
+    for (int i = 0; i < ES7210_REG_COUNT; i++) {
+      uint8_t reg = 0;
+      if (!regs.isReadable(i)) continue;
+      regs.readUncached(i, &reg);
+      AD_LOGI("REG:%02x, %02x", i, reg);
     }
   }
-  /// @brief Read regs of ES7210
+
+  /// Restores the configuration after a reset or power cycle of the chip
+  /// w/o running the full init: only the known registers are written
+  error_t resync() {
+    // as in start(): clocks, power and microphones are enabled after the
+    // configuration
+    static const uint8_t last[] = {
+        ES7210_CLOCK_OFF_REG01,  ES7210_POWER_DOWN_REG06,
+        ES7210_MIC1_POWER_REG47, ES7210_MIC2_POWER_REG48,
+        ES7210_MIC3_POWER_REG49, ES7210_MIC4_POWER_REG4A,
+        ES7210_MIC12_POWER_REG4B, ES7210_MIC34_POWER_REG4C};
+    I2CTransaction transaction(i2c_handle);
+    return regs.resync(last, sizeof(last));
+  }
+
+  /// Register writes only update the cache until flush() is called, so that
+  /// repeated writes to the same register are sent only once
+  void beginDeferred() { regs.beginDeferred(); }
+
+  /// Writes the registers changed since beginDeferred() sorted by address
+  error_t flush() {
+    I2CTransaction transaction(i2c_handle);
+    return regs.flush();
+  }
+
+  /// Serialises the register cache (see AudioDriver::saveState())
+  error_t saveState(StateBlobWriter& out) { return regs.save(out); }
+
+  /// Restores a state created by saveState() on a chip in its power-on state
+  /// w/o running the full init
+  error_t restoreState(StateBlobReader& in) {
+    if (regs.load(in) != RESULT_OK) return RESULT_FAIL;
+    return resync();
+  }
+  /// @brief Read regs of ES7210 (from the cache if possible)
   int readReg(uint8_t reg_addr) {
-    uint8_t data;
-    i2c_bus_read_bytes(i2c_handle, i2c_addr, &reg_addr, sizeof(reg_addr),
-                        &data, sizeof(data));
+    uint8_t data = 0;
+    regs.read(reg_addr, &data);
     return (int)data;
   }
 
+  /// Writes the register: unchanged values are not sent again
   error_t writeReg(uint8_t reg_addr, uint8_t data) {
-    return i2c_bus_write_bytes(i2c_handle, i2c_addr, &reg_addr,
-                                sizeof(reg_addr), &data, sizeof(data));
+    return regs.write(reg_addr, data);
   }
 
   error_t updateRegBit(uint8_t reg_addr, uint8_t update_bits, uint8_t data) {
-    uint8_t regv;
-    regv = readReg(reg_addr);
-    regv = (regv & (~update_bits)) | (update_bits & data);
-    return writeReg(reg_addr, regv);
+    return regs.update(reg_addr, update_bits, data);
   }
 
   int getCoeff(uint32_t mclk, uint32_t lrck) {
@@ -613,6 +652,41 @@ class ES7210 {
   int i2c_addr = ES7210_ADDR;
   es7210_input_mics_t mic_select = static_cast<es7210_input_mics_t>(
       ES7210_INPUT_MIC1 | ES7210_INPUT_MIC2); /* Number of microphones */
+  /// state machine and power down (ordered) and chip id registers
+  struct RegInfo {
+    static uint8_t flags(size_t reg) {
+      static constexpr RegDesc reg_desc[] = {
+          {ES7210_RESET_REG00, REG_ORDERED},
+          {ES7210_POWER_DOWN_REG06, REG_ORDERED},
+          {ES7210_CHIP_ID1_REG3D, REG_READ_ONLY},
+          {ES7210_CHIP_ID0_REG3E, REG_READ_ONLY},
+          {ES7210_CHIP_VER_REG3F, REG_READ_ONLY},
+      };
+      static_assert(reg_desc_valid(reg_desc, ES7210_REG_COUNT),
+                    "ES7210 reg_desc");
+      return reg_desc_flags(reg_desc, reg);
+    }
+  };
+  /// shadow copy of the registers
+  RegMap<uint8_t, uint8_t, ES7210_REG_COUNT, RegInfo> regs{
+      this, busWrite, busRead, busWriteBatch};
+
+  static error_t busWrite(void* ref, uint8_t reg, uint8_t value) {
+    ES7210* self = (ES7210*)ref;
+    return i2c_bus_write_bytes(self->i2c_handle, self->i2c_addr, &reg, 1,
+                               &value, 1);
+  }
+
+  static error_t busRead(void* ref, uint8_t reg, uint8_t* value) {
+    ES7210* self = (ES7210*)ref;
+    return i2c_bus_read_bytes(self->i2c_handle, self->i2c_addr, &reg, 1,
+                              value, 1);
+  }
+
+  static error_t busWriteBatch(void* ref, const RegWrite* list, int n) {
+    ES7210* self = (ES7210*)ref;
+    return i2c_bus_write_batch(self->i2c_handle, self->i2c_addr, list, n);
+  }
 };
 
 }  // namespace audio_driver
@@ -28,6 +28,8 @@
 #include "Codecs/CodecConstants.h"
 #include "DriverCommon.h"
 #include "Platforms/API_I2C.h"
+#include "Platforms/RegMap.h"
+#include "Platforms/RegScript.h"
 #include "stdbool.h"
 #include <assert.h>
 #include <math.h>
@@ -294,6 +296,8 @@ class ES8311 {
   static constexpr uint8_t ES8311_CHD2_REGFE = 0xFE;
   static constexpr uint8_t ES8311_CHVER_REGFF = 0xFF;
   static constexpr uint8_t ES8311_MAX_REGISTER = 0xFF;
+  /// number of cached registers (the chip id registers are not cached)
+  static constexpr int ES8311_REG_COUNT = 0x4A;
   static constexpr int bitVal(int nr) { return 1 << nr; }
   ES8311() = default;
 
@@ -311,22 +315,13 @@ class ES8311 {
 
   /// @brief Initialize ES8311 codec chip
   error_t init(codec_config_t* codec_cfg) {
-    uint8_t datmp, regv;
-    int coeff;
+    uint8_t regv;
     error_t ret = RESULT_OK;
     assert(i2c_handle != NULL);
+    // the chip might have been reset or powered off
+    regs.invalidate();
 
-    ret |= writeReg(ES8311_CLK_MANAGER_REG01, 0x30);
-    ret |= writeReg(ES8311_CLK_MANAGER_REG02, 0x00);
-    ret |= writeReg(ES8311_CLK_MANAGER_REG03, 0x10);
-    ret |= writeReg(ES8311_ADC_REG16, 0x24);
-    ret |= writeReg(ES8311_CLK_MANAGER_REG04, 0x10);
-    ret |= writeReg(ES8311_CLK_MANAGER_REG05, 0x00);
-    ret |= writeReg(ES8311_SYSTEM_REG0B, 0x00);
-    ret |= writeReg(ES8311_SYSTEM_REG0C, 0x00);
-    ret |= writeReg(ES8311_SYSTEM_REG10, 0x1F);
-    ret |= writeReg(ES8311_SYSTEM_REG11, 0x7F);
-    ret |= writeReg(ES8311_RESET_REG00, 0x80);
+    ret |= runScript(initScript());
     /*
      * Set Codec into Master or Slave mode
      */
@@ -372,9 +367,47 @@ class ES8311 {
         ret |= writeReg(ES8311_CLK_MANAGER_REG01, regv);
         break;
     }
+    if (configSample(i2s_cfg->rate) != RESULT_OK) return RESULT_FAIL;
+
+    /*
+     * mclk inverted or not
+     */
+    if (INVERT_MCLK) {
+      regv = readReg(ES8311_CLK_MANAGER_REG01);
+      regv |= 0x40;
+      ret |= writeReg(ES8311_CLK_MANAGER_REG01, regv);
+    } else {
+      regv = readReg(ES8311_CLK_MANAGER_REG01);
+      regv &= ~(0x40);
+      ret |= writeReg(ES8311_CLK_MANAGER_REG01, regv);
+    }
+    /*
+     * sclk inverted or not
+     */
+    if (INVERT_SCLK) {
+      regv = readReg(ES8311_CLK_MANAGER_REG06);
+      regv |= 0x20;
+      ret |= writeReg(ES8311_CLK_MANAGER_REG06, regv);
+    } else {
+      regv = readReg(ES8311_CLK_MANAGER_REG06);
+      regv &= ~(0x20);
+      ret |= writeReg(ES8311_CLK_MANAGER_REG06, regv);
+    }
+
+    ret |= runScript(initAdcScript());
+
+    // setPaPower(true);
+    return RESULT_OK;
+  }
+
+  /// Sets the clock coefficients (dividers) for the sample rate
+  error_t configSample(samplerate_t rate) {
+    uint8_t datmp, regv;
+    int coeff;
+    error_t ret = RESULT_OK;
     int sample_fre = 0;
     int mclk_fre = 0;
-    switch (i2s_cfg->rate) {
+    switch (rate) {
       case RATE_8K:
         sample_fre = 8000;
         break;
@@ -470,38 +503,17 @@ class ES8311 {
       }
       ret |= writeReg(ES8311_CLK_MANAGER_REG06, regv);
     }
+    return ret;
+  }
 
-    /*
-     * mclk inverted or not
-     */
-    if (INVERT_MCLK) {
-      regv = readReg(ES8311_CLK_MANAGER_REG01);
-      regv |= 0x40;
-      ret |= writeReg(ES8311_CLK_MANAGER_REG01, regv);
-    } else {
-      regv = readReg(ES8311_CLK_MANAGER_REG01);
-      regv &= ~(0x40);
-      ret |= writeReg(ES8311_CLK_MANAGER_REG01, regv);
-    }
-    /*
-     * sclk inverted or not
-     */
-    if (INVERT_SCLK) {
-      regv = readReg(ES8311_CLK_MANAGER_REG06);
-      regv |= 0x20;
-      ret |= writeReg(ES8311_CLK_MANAGER_REG06, regv);
-    } else {
-      regv = readReg(ES8311_CLK_MANAGER_REG06);
-      regv &= ~(0x20);
-      ret |= writeReg(ES8311_CLK_MANAGER_REG06, regv);
-    }
-
-    ret |= writeReg(ES8311_SYSTEM_REG13, 0x10);
-    ret |= writeReg(ES8311_ADC_REG1B, 0x0A);
-    ret |= writeReg(ES8311_ADC_REG1C, 0x6A);
-
-    // setPaPower(true);
-    return RESULT_OK;
+  /// Changes only the sample rate: the DAC is soft muted while the clock
+  /// coefficients are reprogrammed
+  error_t changeSampleRate(samplerate_t rate) {
+    uint8_t regv = readReg(ES8311_DAC_REG31);
+    error_t ret = writeReg(ES8311_DAC_REG31, regv | 0x60);
+    ret |= configSample(rate);
+    ret |= writeReg(ES8311_DAC_REG31, regv);
+    return ret;
   }
 
   /// @brief Deinitialize ES8311 codec chip
@@ -624,23 +636,74 @@ class ES8311 {
 
   /// @brief Print all ES8311 registers
   void readAll() {
-    for (int i = 0; i < 0x4A; i++) {
-      uint8_t reg = readReg(i);
-      AD_LOGI("REG:%02x, %02x", reg, i);
+    uint8_t values[ES8311_REG_COUNT] = {0};
+    if (readRegs(0, values, sizeof(values)) == RESULT_OK) {
+      regs.set(0, values, sizeof(values));
+    }
+    for (int i = 0; i < ES8311_REG_COUNT; i++) {
+      AD_LOGI("REG:%02x, %02x", i, values[i]);
     }
   }
+
+  /// Restores the configuration after a reset or power cycle of the chip
+  /// w/o running the full init: only the known registers are written
+  error_t resync() {
+    // as in init() and start(): the state machine is started after the
+    // clock setup and the analog power up and unmute come last
+    static const uint8_t last[] = {ES8311_RESET_REG00, ES8311_SYSTEM_REG0D,
+                                   ES8311_DAC_REG31};
+    I2CTransaction transaction(i2c_handle);
+    return regs.resync(last, sizeof(last));
+  }
+
+  /// Register writes only update the cache until flush() is called, so that
+  /// repeated writes to the same register are sent only once
+  void beginDeferred() { regs.beginDeferred(); }
+
+  /// Writes the registers changed since beginDeferred() sorted by address
+  error_t flush() {
+    I2CTransaction transaction(i2c_handle);
+    return regs.flush();
+  }
+
+  /// Serialises the register cache and the driver settings (see
+  /// AudioDriver::saveState())
+  error_t saveState(StateBlobWriter& out) {
+    out.put8((uint8_t)mclk_src);
+    return regs.save(out);
+  }
+
+  /// Restores a state created by saveState() on a chip in its power-on state
+  /// w/o running the full init
+  error_t restoreState(StateBlobReader& in) {
+    int8_t src = (int8_t)in.get8();
+    if (regs.load(in) != RESULT_OK) return RESULT_FAIL;
+    mclk_src = src;
+    return resync();
+  }
+  /// Writes the register: unchanged values are not sent again
   error_t writeReg(uint8_t reg_addr, uint8_t data) {
-    return i2c_bus_write_bytes(i2c_handle, i2c_addr, &reg_addr,
-                                sizeof(reg_addr), &data, sizeof(data));
+    return regs.write(reg_addr, data);
+  }
+
+  /// Writes a list of registers in one batch: only cached in deferred mode
+  error_t writeRegs(const RegWrite* list, int n) {
+    return regs.writeBatch(list, n);
   }
 
+  /// Provides the register value from the cache or the chip
   int readReg(uint8_t reg_addr) {
-    uint8_t data;
-    i2c_bus_read_bytes(i2c_handle, i2c_addr, &reg_addr, sizeof(reg_addr),
-                        &data, sizeof(data));
+    uint8_t data = 0;
+    regs.read(reg_addr, &data);
     return (int)data;
   }
 
+  /// Reads n consecutive registers with block reads of up to I2C_MAX_BURST
+  /// bytes (e.g. 2 or 3 transactions for a register dump)
+  error_t readRegs(uint8_t reg_addr, uint8_t* data, int n) {
+    return i2c_bus_read_regs(i2c_handle, i2c_addr, reg_addr, data, n);
+  }
+
   /// look for the coefficient in es8311_coeff_div[] table
   int getCoeff(uint32_t mclk, uint32_t rate) {
     for (unsigned i = 0;
@@ -670,15 +733,14 @@ class ES8311 {
   /// set es8311 into suspend mode
   void suspend(void) {
     AD_LOGI("Enter into suspend()");
-    writeReg(ES8311_DAC_REG32, 0x00);
-    writeReg(ES8311_ADC_REG17, 0x00);
-    writeReg(ES8311_SYSTEM_REG0E, 0xFF);
-    writeReg(ES8311_SYSTEM_REG12, 0x02);
-    writeReg(ES8311_SYSTEM_REG14, 0x00);
-    writeReg(ES8311_SYSTEM_REG0D, 0xFA);
-    writeReg(ES8311_ADC_REG15, 0x00);
-    writeReg(ES8311_DAC_REG37, 0x08);
-    writeReg(ES8311_GP_REG45, 0x01);
+    static const RegWrite suspend_regs[] = {
+        {ES8311_DAC_REG32, 0x00},    {ES8311_ADC_REG17, 0x00},
+        {ES8311_SYSTEM_REG0E, 0xFF}, {ES8311_SYSTEM_REG12, 0x02},
+        {ES8311_SYSTEM_REG14, 0x00}, {ES8311_SYSTEM_REG0D, 0xFA},
+        {ES8311_ADC_REG15, 0x00},    {ES8311_DAC_REG37, 0x08},
+        {ES8311_GP_REG45, 0x01},
+    };
+    writeRegs(suspend_regs, sizeof(suspend_regs) / sizeof(suspend_regs[0]));
   }
 
   /// Configure ES8311 I2S format
@@ -768,13 +830,12 @@ class ES8311 {
       dac_iface &= ~(bitVal(6));
     }
 
-    ret |= writeReg(ES8311_SDPIN_REG09, dac_iface);
-    ret |= writeReg(ES8311_SDPOUT_REG0A, adc_iface);
-
-    ret |= writeReg(ES8311_ADC_REG17, 0xBF);
-    ret |= writeReg(ES8311_SYSTEM_REG0E, 0x02);
-    ret |= writeReg(ES8311_SYSTEM_REG12, 0x00);
-    ret |= writeReg(ES8311_SYSTEM_REG14, 0x1A);
+    const RegWrite start_regs[] = {
+        {ES8311_SDPIN_REG09, dac_iface}, {ES8311_SDPOUT_REG0A, adc_iface},
+        {ES8311_ADC_REG17, 0xBF},        {ES8311_SYSTEM_REG0E, 0x02},
+        {ES8311_SYSTEM_REG12, 0x00},     {ES8311_SYSTEM_REG14, 0x1A},
+    };
+    ret |= writeRegs(start_regs, sizeof(start_regs) / sizeof(start_regs[0]));
 
     /*
      * pdm dmic enable or disable
@@ -790,10 +851,13 @@ class ES8311 {
       ret |= writeReg(ES8311_SYSTEM_REG14, regv);
     }
 
-    ret |= writeReg(ES8311_SYSTEM_REG0D, 0x01);
-    ret |= writeReg(ES8311_ADC_REG15, 0x40);
-    ret |= writeReg(ES8311_DAC_REG37, 0x48);
-    ret |= writeReg(ES8311_GP_REG45, 0x00);
+    static const RegWrite start_power[] = {
+        {ES8311_SYSTEM_REG0D, 0x01},
+        {ES8311_ADC_REG15, 0x40},
+        {ES8311_DAC_REG37, 0x48},
+        {ES8311_GP_REG45, 0x00},
+    };
+    ret |= writeRegs(start_power, sizeof(start_power) / sizeof(start_power[0]));
 
     return ret;
   }
@@ -809,6 +873,78 @@ class ES8311 {
   i2c_bus_handle_t i2c_handle = nullptr;
   int i2c_addr = ES8311_ADDR;
   int8_t mclk_src = 0;
+  /// state machine, power and DAC mute: the write order must be kept
+  struct RegInfo {
+    static uint8_t flags(size_t reg) {
+      static constexpr RegDesc reg_desc[] = {
+          {ES8311_RESET_REG00, REG_ORDERED},
+          {ES8311_SYSTEM_REG0D, REG_ORDERED},
+          {ES8311_DAC_REG31, REG_ORDERED},
+      };
+      static_assert(reg_desc_valid(reg_desc, ES8311_REG_COUNT),
+                    "ES8311 reg_desc");
+      return reg_desc_flags(reg_desc, reg);
+    }
+  };
+  /// shadow copy of the registers
+  RegMap<uint8_t, uint8_t, ES8311_REG_COUNT, RegInfo> regs{
+      this, busWrite, busRead, busWriteBatch};
+
+  /// clock manager defaults and power up: first part of init()
+  static const RegStep* initScript() {
+    static constexpr RegStep script[] = {
+        script_write(ES8311_CLK_MANAGER_REG01, 0x30),
+        script_write(ES8311_CLK_MANAGER_REG02, 0x00),
+        script_write(ES8311_CLK_MANAGER_REG03, 0x10),
+        script_write(ES8311_ADC_REG16, 0x24),
+        script_write(ES8311_CLK_MANAGER_REG04, 0x10),
+        script_write(ES8311_CLK_MANAGER_REG05, 0x00),
+        script_write(ES8311_SYSTEM_REG0B, 0x00),
+        script_write(ES8311_SYSTEM_REG0C, 0x00),
+        script_write(ES8311_SYSTEM_REG10, 0x1F),
+        script_write(ES8311_SYSTEM_REG11, 0x7F),
+        script_write(ES8311_RESET_REG00, 0x80),
+        script_end(),
+    };
+    static_assert(reg_script_valid(script, ES8311_REG_COUNT, 1),
+                  "ES8311 initScript()");
+    return script;
+  }
+
+  /// ADC setup: last part of init()
+  static const RegStep* initAdcScript() {
+    static constexpr RegStep script[] = {
+        script_write(ES8311_SYSTEM_REG13, 0x10),
+        script_write(ES8311_ADC_REG1B, 0x0A),
+        script_write(ES8311_ADC_REG1C, 0x6A),
+        script_end(),
+    };
+    static_assert(reg_script_valid(script, ES8311_REG_COUNT, 1),
+                  "ES8311 initAdcScript()");
+    return script;
+  }
+
+  /// Executes the register script via the register cache
+  error_t runScript(const RegStep* script, const uint16_t* args = nullptr) {
+    return reg_script_run(reg_script_bus(regs), script, args);
+  }
+
+  static error_t busWrite(void* ref, uint8_t reg, uint8_t value) {
+    ES8311* self = (ES8311*)ref;
+    return i2c_bus_write_bytes(self->i2c_handle, self->i2c_addr, &reg, 1,
+                               &value, 1);
+  }
+
+  static error_t busRead(void* ref, uint8_t reg, uint8_t* value) {
+    ES8311* self = (ES8311*)ref;
+    return i2c_bus_read_bytes(self->i2c_handle, self->i2c_addr, &reg, 1,
+                              value, 1);
+  }
+
+  static error_t busWriteBatch(void* ref, const RegWrite* list, int n) {
+    ES8311* self = (ES8311*)ref;
+    return i2c_bus_write_batch(self->i2c_handle, self->i2c_addr, list, n);
+  }
 };
 
 } /* namespace audio_driver */
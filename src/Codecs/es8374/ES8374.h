@@ -63,10 +63,10 @@ class ES8374 {
 
   /// @brief Print all ES8374 registers
   void readAll() {
+    uint8_t regs[50] = {0};
+    readRegs(0, regs, sizeof(regs));
     for (int i = 0; i < 50; i++) {
-      uint8_t reg = 0;
-      readReg(i, &reg);
-      AD_LOGI("%x: %x", i, reg);
+      AD_LOGI("%x: %x", i, regs[i]);
     }
   }
 
@@ -216,6 +216,11 @@ class ES8374 {
                                 &data, sizeof(data));
   }
 
+  /// Writes a list of registers in one batch
+  error_t writeRegs(const RegWrite* list, int n) {
+    return i2c_bus_write_batch(i2c_handle, i2c_addr, list, n);
+  }
+
   int readReg(uint8_t reg_add, uint8_t* regv) {
     uint8_t regdata = 0xFF;
     uint8_t res = 0;
@@ -231,6 +236,12 @@ class ES8374 {
     }
   }
 
+  /// Reads n consecutive registers with block reads of up to I2C_MAX_BURST
+  /// bytes (e.g. 2 or 3 transactions for a register dump)
+  error_t readRegs(uint8_t reg_add, uint8_t* regv, int n) {
+    return i2c_bus_read_regs(i2c_handle, i2c_addr, reg_add, regv, n);
+  }
+
   /// Configure ES8374 data sample bits
   error_t setBitsPerSample(codec_mode_t mode, sample_bits_t bit_per_sample) {
     error_t res = RESULT_OK;
@@ -696,64 +707,77 @@ class ES8374 {
     error_t res = RESULT_OK;
     uint8_t reg;
 
-    res |= writeReg(0x00, 0x3F);  // IC Rst start
-    res |= writeReg(0x00, 0x03);  // IC Rst stop
-    res |= writeReg(0x01, 0x7F);  // IC clk on
+    static const RegWrite reset_regs[] = {
+        {0x00, 0x3F},  // IC Rst start
+        {0x00, 0x03},  // IC Rst stop
+        {0x01, 0x7F},  // IC clk on
+    };
+    res |= writeRegs(reset_regs, sizeof(reset_regs) / sizeof(reset_regs[0]));
 
     res |= readReg(0x0F, &reg);
     reg &= 0x7f;
     reg |= (ms_mode << 7);
     res |= writeReg(0x0f, reg);  // CODEC IN I2S SLAVE MODE
 
-    res |= writeReg(0x6F, 0xA0);  // pll set:mode enable
-    res |= writeReg(0x72, 0x41);  // pll set:mode set
-    res |= writeReg(0x09, 0x01);  // pll set:reset on ,set start
-    res |= writeReg(0x0C, 0x22);  // pll set:k
-    res |= writeReg(0x0D, 0x2E);  // pll set:k
-    res |= writeReg(0x0E, 0xC6);  // pll set:k
-    res |= writeReg(0x0A, 0x3A);  // pll set:
-    res |= writeReg(0x0B, 0x07);  // pll set:n
-    res |= writeReg(0x09, 0x41);  // pll set:reset off ,set stop
+    static const RegWrite pll_regs[] = {
+        {0x6F, 0xA0},  // pll set:mode enable
+        {0x72, 0x41},  // pll set:mode set
+        {0x09, 0x01},  // pll set:reset on ,set start
+        {0x0C, 0x22},  // pll set:k
+        {0x0D, 0x2E},  // pll set:k
+        {0x0E, 0xC6},  // pll set:k
+        {0x0A, 0x3A},  // pll set:
+        {0x0B, 0x07},  // pll set:n
+        {0x09, 0x41},  // pll set:reset off ,set stop
+    };
+    res |= writeRegs(pll_regs, sizeof(pll_regs) / sizeof(pll_regs[0]));
 
     res |= i2sConfigClock(cfg);
 
-    res |= writeReg(0x24, 0x08);  // adc set
-    res |= writeReg(0x36, 0x00);  // dac set
-    res |= writeReg(0x12, 0x30);  // timming set
-    res |= writeReg(0x13, 0x20);  // timming set
+    static const RegWrite timing_regs[] = {
+        {0x24, 0x08},  // adc set
+        {0x36, 0x00},  // dac set
+        {0x12, 0x30},  // timming set
+        {0x13, 0x20},  // timming set
+    };
+    res |= writeRegs(timing_regs, sizeof(timing_regs) / sizeof(timing_regs[0]));
 
     // TODO
     res |= configFmt(CODEC_MODE_ENCODE, fmt);
     res |= configFmt(CODEC_MODE_DECODE, fmt);
 
-    res |= writeReg(0x21, 0x50);  // adc set: SEL LIN1 CH+PGAGAIN=0DB
-    res |= writeReg(0x22, 0xFF);  // adc set: PGA GAIN=0DB
-    res |= writeReg(0x21, 0x14);  // adc set: SEL LIN1 CH+PGAGAIN=18DB
-    res |= writeReg(0x22, 0x55);  // pga = +15db
-    res |=
-        writeReg(0x08, 0x21);  // set class d divider = 33, to avoid the
-                               // high frequency tone on laudspeaker
-    res |= writeReg(0x00, 0x80);  // IC START
+    static const RegWrite adc_regs[] = {
+        {0x21, 0x50},  // adc set: SEL LIN1 CH+PGAGAIN=0DB
+        {0x22, 0xFF},  // adc set: PGA GAIN=0DB
+        {0x21, 0x14},  // adc set: SEL LIN1 CH+PGAGAIN=18DB
+        {0x22, 0x55},  // pga = +15db
+        {0x08, 0x21},  // set class d divider = 33, to avoid the
+                       // high frequency tone on laudspeaker
+        {0x00, 0x80},  // IC START
+    };
+    res |= writeRegs(adc_regs, sizeof(adc_regs) / sizeof(adc_regs[0]));
 
     res |= setAdcDacVolume(CODEC_MODE_ENCODE, 0, 0);  // 0db
     res |= setAdcDacVolume(CODEC_MODE_DECODE, 0, 0);  // 0db
 
-    res |= writeReg(0x14, 0x8A);  // IC START
-    res |= writeReg(0x15, 0x40);  // IC START
-    res |= writeReg(0x1A, 0xA0);  // monoout set
-    res |= writeReg(0x1B, 0x19);  // monoout set
-    res |= writeReg(0x1C, 0x90);  // spk set
-    res |= writeReg(0x1D, 0x01);  // spk set
-    res |= writeReg(0x1F, 0x00);  // spk set
-    res |= writeReg(0x1E, 0x20);  // spk on
-    res |= writeReg(0x28, 0x00);  // alc set
-    res |= writeReg(0x25, 0x00);  // ADCVOLUME on
-    res |= writeReg(0x38, 0x00);  // DACVOLUME on
-    res |= writeReg(0x37, 0x30);  // dac set
-    res |= writeReg(0x6D,
-                     0x60);  // SEL:GPIO1=DMIC CLK OUT+SEL:GPIO2=PLL CLK OUT
-    res |= writeReg(0x71, 0x05);  // for automute setting
-    res |= writeReg(0x73, 0x70);
+    static const RegWrite output_regs[] = {
+        {0x14, 0x8A},  // IC START
+        {0x15, 0x40},  // IC START
+        {0x1A, 0xA0},  // monoout set
+        {0x1B, 0x19},  // monoout set
+        {0x1C, 0x90},  // spk set
+        {0x1D, 0x01},  // spk set
+        {0x1F, 0x00},  // spk set
+        {0x1E, 0x20},  // spk on
+        {0x28, 0x00},  // alc set
+        {0x25, 0x00},  // ADCVOLUME on
+        {0x38, 0x00},  // DACVOLUME on
+        {0x37, 0x30},  // dac set
+        {0x6D, 0x60},  // SEL:GPIO1=DMIC CLK OUT+SEL:GPIO2=PLL CLK OUT
+        {0x71, 0x05},  // for automute setting
+        {0x73, 0x70},
+    };
+    res |= writeRegs(output_regs, sizeof(output_regs) / sizeof(output_regs[0]));
 
     res |= configOutputDevice();  // 0x3c Enable DAC and Enable
                                    // Lout/Rout/1/2
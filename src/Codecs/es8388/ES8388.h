@@ -29,6 +29,8 @@
 #include "Codecs/CodecConstants.h"
 #include "DriverCommon.h"
 #include "Platforms/API_I2C.h"
+#include "Platforms/RegMap.h"
+#include "Platforms/RegScript.h"
 #include "stdbool.h"
 #include <string.h>
 
@@ -117,6 +119,8 @@ class ES8388 {
   static constexpr uint8_t ES8388_DACCONTROL28 = 0x32;
   static constexpr uint8_t ES8388_DACCONTROL29 = 0x33;
   static constexpr uint8_t ES8388_DACCONTROL30 = 0x34;
+  /// number of cached registers (incl. the DLL registers 0x35-0x39)
+  static constexpr int ES8388_REG_COUNT = 0x3A;
   ES8388() = default;
 
   /// Defines the I2C bus instance to be used
@@ -136,23 +140,61 @@ class ES8388 {
   /// @brief Print all ES8388 registers
   void readAll() {
     AD_TRACED();
+    uint8_t values[50] = {0};
+    if (readRegs(0, values, sizeof(values)) == RESULT_OK) {
+      regs.set(0, values, sizeof(values));
+    }
     for (int i = 0; i < 50; i++) {
-      uint8_t reg = 0;
-      readReg(i, &reg);
-      AD_LOGI("%x: %x", i, reg);
+      AD_LOGI("%x: %x", i, values[i]);
     }
   }
 
+  /// Restores the configuration after a reset or power cycle of the chip
+  /// w/o running the full init: only the known registers are written
+  error_t resync() {
+    // as in start(): the state machine is started and the ADC and DAC are
+    // powered up after the configuration
+    static const uint8_t last[] = {ES8388_CHIPPOWER, ES8388_ADCPOWER,
+                                   ES8388_DACPOWER};
+    I2CTransaction transaction(i2c_handle);
+    return regs.resync(last, sizeof(last));
+  }
+
+  /// Register writes only update the cache until flush() is called, so that
+  /// repeated writes to the same register are sent only once
+  void beginDeferred() { regs.beginDeferred(); }
+
+  /// Writes the registers changed since beginDeferred() sorted by address
+  error_t flush() {
+    I2CTransaction transaction(i2c_handle);
+    return regs.flush();
+  }
+
+  /// Serialises the register cache and the driver settings (see
+  /// AudioDriver::saveState())
+  error_t saveState(StateBlobWriter& out) {
+    out.put8((uint8_t)dac_power);
+    out.put8((uint8_t)volume_hack);
+    return regs.save(out);
+  }
+
+  /// Restores a state created by saveState() on a chip in its power-on state
+  /// w/o running the full init
+  error_t restoreState(StateBlobReader& in) {
+    int power = in.get8();
+    int hack = in.get8();
+    if (regs.load(in) != RESULT_OK) return RESULT_FAIL;
+    dac_power = power;
+    volume_hack = hack;
+    return resync();
+  }
+
   /// @brief Configure ES8388 DAC mute or not.
   error_t setVoiceMute(bool enable) {
     AD_TRACED();
-    error_t res = RESULT_OK;
-    uint8_t reg = 0;
-    res = readReg(ES8388_DACCONTROL3, &reg);
-    reg = reg & 0xC3;               // keep 11000011
-    int value = enable ? 0x3C : 0;  // enable is 00111100 / disable is 00000000
-    res |= writeReg(ES8388_DACCONTROL3, value | reg);
-    return res;
+    I2CTransaction transaction(i2c_handle);
+    // keep 11000011: enable is 00111100 / disable is 00000000
+    return regs.update(ES8388_DACCONTROL3, 0x3C, enable ? 0x3C : 0);
   }
 
   /// @brief Get ES8388 DAC mute status
@@ -345,46 +387,13 @@ class ES8388 {
   error_t init(codec_config_t* cfg, int volumeHack) {
     AD_TRACED();
     volume_hack = volumeHack;
+    // the chip might have been reset or powered off
+    regs.invalidate();
 
     int res = 0;
 
-    res |= writeReg(ES8388_DACCONTROL3,
-                     0x04);  // 0x04 mute/0x00 unmute&ramp;DAC unmute and
-                             // disabled digital volume control soft ramp
-    /* Chip Control and Power Management */
-    res |= writeReg(ES8388_CONTROL2, 0x50);
-    res |= writeReg(ES8388_CHIPPOWER, 0x00);  // normal all and power up all
-
-    // Disable the internal DLL to improve 8K sample rate
-    res |= writeReg(0x35, 0xA0);
-    res |= writeReg(0x37, 0xD0);
-    res |= writeReg(0x39, 0xD0);
-
-    res |= writeReg(ES8388_MASTERMODE,
-                     cfg->i2s.mode);  // CODEC IN I2S SLAVE MODE
-
-    /* dac */
-    res |= writeReg(ES8388_DACPOWER,
-                     0xC0);  // disable DAC and disable Lout/Rout/1/2
-    res |= writeReg(
-        ES8388_CONTROL1,
-        0x12);  // Enfr=0,Play&Record Mode,(0x17-both of mic&paly)
-    //    res |= writeReg(ES8388_CONTROL2, 0);
-    //    //LPVrefBuf=0,Pdn_ana=0
-    res |= writeReg(ES8388_DACCONTROL1,
-                     0x18);  // 1a 0x18:16bit iis , 0x00:24
-    res |= writeReg(ES8388_DACCONTROL2,
-                     0x02);  // DACFsMode,SINGLE SPEED; DACFsRatio,256
-    res |= writeReg(ES8388_DACCONTROL16,
-                     0x00);  // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2
-    res |= writeReg(ES8388_DACCONTROL17,
-                     0x90);  // only left DAC to left mixer enable 0db
-    res |= writeReg(ES8388_DACCONTROL20,
-                     0x90);  // only right DAC to right mixer enable 0db
-    res |= writeReg(ES8388_DACCONTROL21,
-                     0x80);  // set internal ADC and DAC use the same LRCK
-                             // clock, ADC LRCK as internal LRCK
-    res |= writeReg(ES8388_DACCONTROL23, 0x00);          // vroi=0
+    const uint16_t dac_args[] = {(uint16_t)cfg->i2s.mode};
+    res |= runScript(initDacScript(), dac_args);
     res |= setAdcDacVolume(CODEC_MODE_DECODE, 0, 0);  // 0db
     dac_power = 0;
     AD_LOGI("output_device: %d", cfg->output_device);
@@ -396,11 +405,8 @@ class ES8388 {
       dac_power = ES8388_OUTPUT_LOUT1 | ES8388_OUTPUT_LOUT2 |
                   ES8388_OUTPUT_ROUT1 | ES8388_OUTPUT_ROUT2;
     }
-    res |= writeReg(
-        ES8388_DACPOWER,
-        dac_power);  // 0x3c Enable DAC and Enable Lout/Rout/1/2
-    /* adc */
-    res |= writeReg(ES8388_ADCPOWER, 0xFF);
+    const uint16_t power_args[] = {(uint16_t)dac_power};
+    res |= runScript(initPowerScript(), power_args);
 
     // // AudioDriver: WORKAROUND_MIC_LINEIN_MIXED
     es_mic_gain_t mic_gain = (es_mic_gain_t)ES8388_DEFAULT_INPUT_GAIN;
@@ -425,15 +431,8 @@ class ES8388 {
     } else {
       tmp = ESP8388_INPUT_DIFFERENCE;
     }
-    res |= writeReg(ES8388_ADCCONTROL2,
-                     tmp);  // 0x00 LINSEL & RINSEL, LIN1/RIN1 as ADC Input;
-                            // DSSEL,use one DS Reg11; DSR, LINPUT1-RINPUT1
-    res |= writeReg(ES8388_ADCCONTROL3, 0x02);
-    res |= writeReg(ES8388_ADCCONTROL4,
-                     0x0d);  // Left/Right data, Left/Right justified mode,
-                             // Bits length, I2S format
-    res |= writeReg(ES8388_ADCCONTROL5,
-                     0x02);  // ADCFsMode,singel SPEED,RATIO=256
+    const uint16_t adc_args[] = {(uint16_t)tmp};
+    res |= runScript(initAdcScript(), adc_args);
     // ALC for Microphone
     res |= setAdcDacVolume(CODEC_MODE_ENCODE, 0, 0);  // 0db
     res |= writeReg(ES8388_ADCPOWER,
@@ -487,14 +486,25 @@ class ES8388 {
     }
     return res;
   }
+  /// Writes the register: unchanged values are not sent again
   error_t writeReg(uint8_t reg_add, uint8_t data) {
-    return i2c_bus_write_bytes(i2c_handle, i2c_addr, &reg_add, sizeof(reg_add),
-                                &data, sizeof(data));
+    return regs.write(reg_add, data);
+  }
+
+  /// Writes a list of registers in one batch: only cached in deferred mode
+  error_t writeRegs(const RegWrite* list, int n) {
+    return regs.writeBatch(list, n);
   }
 
+  /// Provides the register value from the cache or the chip
   error_t readReg(uint8_t reg_add, uint8_t* p_data) {
-    return i2c_bus_read_bytes(i2c_handle, i2c_addr, &reg_add, sizeof(reg_add),
-                               p_data, 1);
+    return regs.read(reg_add, p_data);
+  }
+
+  /// Reads n consecutive registers with block reads of up to I2C_MAX_BURST
+  /// bytes (e.g. 2 or 3 transactions for a register dump)
+  error_t readRegs(uint8_t reg_add, uint8_t* p_data, int n) {
+    return i2c_bus_read_regs(i2c_handle, i2c_addr, reg_add, p_data, n);
   }
 
   error_t setAdcDacVolume(int mode, int volume, int dot) {
@@ -601,10 +611,11 @@ class ES8388 {
     }
     readReg(ES8388_DACCONTROL21, &data);
     if (prev_data != data) {
-      res |= writeReg(ES8388_CHIPPOWER, 0xF0);  // start state machine
+      // restart the state machine: never skipped or merged
+      res |= regs.writeForced(ES8388_CHIPPOWER, 0xF0);
       // res |= writeReg(ES8388_CONTROL1, 0x16);
       // res |= writeReg(ES8388_CONTROL2, 0x50);
-      res |= writeReg(ES8388_CHIPPOWER, 0x00);  // start state machine
+      res |= regs.writeForced(ES8388_CHIPPOWER, 0x00);
     }
     if (mode == CODEC_MODE_ENCODE || mode == CODEC_MODE_BOTH ||
         mode == CODEC_MODE_LINE_IN) {
@@ -711,8 +722,111 @@ class ES8388 {
  protected:
   i2c_bus_handle_t i2c_handle = nullptr;
   int i2c_addr = ES8388_ADDR;
+  /// power registers: the power sequence must not be merged
+  struct RegInfo {
+    static uint8_t flags(size_t reg) {
+      static constexpr RegDesc reg_desc[] = {
+          {ES8388_CHIPPOWER, REG_ORDERED},
+          {ES8388_ADCPOWER, REG_ORDERED},
+          {ES8388_DACPOWER, REG_ORDERED},
+      };
+      static_assert(reg_desc_valid(reg_desc, ES8388_REG_COUNT),
+                    "ES8388 reg_desc");
+      return reg_desc_flags(reg_desc, reg);
+    }
+  };
+  /// shadow copy of the registers
+  RegMap<uint8_t, uint8_t, ES8388_REG_COUNT, RegInfo> regs{
+      this, busWrite, busRead, busWriteBatch};
   int dac_power = 0x3c;
   int volume_hack = AI_THINKER_ES8388_VOLUME_HACK;
+
+  /// first part of init(): args[0] is the I2S mode
+  static const RegStep* initDacScript() {
+    static constexpr RegStep script[] = {
+        // 0x04 mute/0x00 unmute&ramp;DAC unmute and disabled digital volume
+        // control soft ramp
+        script_write(ES8388_DACCONTROL3, 0x04),
+        /* Chip Control and Power Management */
+        script_write(ES8388_CONTROL2, 0x50),
+        script_write(ES8388_CHIPPOWER, 0x00),  // normal all and power up all
+        // Disable the internal DLL to improve 8K sample rate
+        script_write(0x35, 0xA0),
+        script_write(0x37, 0xD0),
+        script_write(0x39, 0xD0),
+        script_write_arg(ES8388_MASTERMODE, 0),  // CODEC IN I2S SLAVE MODE
+        /* dac */
+        script_write(ES8388_DACPOWER, 0xC0),  // disable DAC and disable Lout/Rout/1/2
+        script_write(ES8388_CONTROL1, 0x12),  // Enfr=0,Play&Record Mode,(0x17-both of mic&paly)
+        //    {ES8388_CONTROL2, 0},  //LPVrefBuf=0,Pdn_ana=0
+        script_write(ES8388_DACCONTROL1, 0x18),   // 1a 0x18:16bit iis , 0x00:24
+        script_write(ES8388_DACCONTROL2, 0x02),   // DACFsMode,SINGLE SPEED; DACFsRatio,256
+        script_write(ES8388_DACCONTROL16, 0x00),  // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2
+        script_write(ES8388_DACCONTROL17, 0x90),  // only left DAC to left mixer enable 0db
+        script_write(ES8388_DACCONTROL20, 0x90),  // only right DAC to right mixer enable 0db
+        // set internal ADC and DAC use the same LRCK clock, ADC LRCK as
+        // internal LRCK
+        script_write(ES8388_DACCONTROL21, 0x80),
+        script_write(ES8388_DACCONTROL23, 0x00),  // vroi=0
+        script_end(),
+    };
+    static_assert(reg_script_valid(script, ES8388_REG_COUNT, 1, 1),
+                  "ES8388 initDacScript()");
+    return script;
+  }
+
+  /// args[0] is the DACPOWER value
+  static const RegStep* initPowerScript() {
+    static constexpr RegStep script[] = {
+        // 0x3c Enable DAC and Enable Lout/Rout/1/2
+        script_write_arg(ES8388_DACPOWER, 0),
+        /* adc */
+        script_write(ES8388_ADCPOWER, 0xFF),
+        script_end(),
+    };
+    static_assert(reg_script_valid(script, ES8388_REG_COUNT, 1, 1),
+                  "ES8388 initPowerScript()");
+    return script;
+  }
+
+  /// args[0] is the ADCCONTROL2 input selection
+  static const RegStep* initAdcScript() {
+    static constexpr RegStep script[] = {
+        // 0x00 LINSEL & RINSEL, LIN1/RIN1 as ADC Input; DSSEL,use one DS
+        // Reg11; DSR, LINPUT1-RINPUT1
+        script_write_arg(ES8388_ADCCONTROL2, 0),
+        script_write(ES8388_ADCCONTROL3, 0x02),
+        // Left/Right data, Left/Right justified mode, Bits length, I2S format
+        script_write(ES8388_ADCCONTROL4, 0x0d),
+        script_write(ES8388_ADCCONTROL5, 0x02),  // ADCFsMode,singel SPEED,RATIO=256
+        script_end(),
+    };
+    static_assert(reg_script_valid(script, ES8388_REG_COUNT, 1, 1),
+                  "ES8388 initAdcScript()");
+    return script;
+  }
+
+  /// Executes the register script via the register cache
+  error_t runScript(const RegStep* script, const uint16_t* args = nullptr) {
+    return reg_script_run(reg_script_bus(regs), script, args);
+  }
+
+  static error_t busWrite(void* ref, uint8_t reg, uint8_t value) {
+    ES8388* self = (ES8388*)ref;
+    return i2c_bus_write_bytes(self->i2c_handle, self->i2c_addr, &reg, 1,
+                               &value, 1);
+  }
+
+  static error_t busRead(void* ref, uint8_t reg, uint8_t* value) {
+    ES8388* self = (ES8388*)ref;
+    return i2c_bus_read_bytes(self->i2c_handle, self->i2c_addr, &reg, 1,
+                              value, 1);
+  }
+
+  static error_t busWriteBatch(void* ref, const RegWrite* list, int n) {
+    ES8388* self = (ES8388*)ref;
+    return i2c_bus_write_batch(self->i2c_handle, self->i2c_addr, list, n);
+  }
 };
 
 }  // namespace audio_driver
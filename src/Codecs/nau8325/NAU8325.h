@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DriverCommon.h"
+#include "Platforms/API_Delay.h"
 #include "Platforms/API_I2C.h"
 #include "Platforms/Logger.h"
 #include "stdint.h"
@@ -444,46 +445,68 @@ class NAU8325 {
 
   /// Initializes the codec with explicit sample rate, bit depth, and MCLK/FS ratio
   bool begin(uint32_t fs, uint8_t bits_per_sample, uint16_t ratio) {
-    AD_LOGI("[NAU8325] beginDynamic() starting...");
-    AD_LOGI("  fs = %lu Hz", fs);
-    AD_LOGI("  ratio = %u Hz", ratio);
-    AD_LOGI("  bits = %u", bits_per_sample);
-
-    if (bits_per_sample != 16 && bits_per_sample != 24 && bits_per_sample != 32) {
-      AD_LOGI("[NAU8325] Unsupported bit width: %u\n", bits_per_sample);
-      return false;
-    }
+    return run_steps([&](int step) {
+      return beginStep(step, fs, bits_per_sample, ratio);
+    });
+  }
 
-    set_ratio = ratio;
+  /// Non-blocking begin(): executes the indicated step and returns the delay
+  /// in ms before the next step, STEP_DONE or STEP_FAILED
+  int beginStep(int step, uint32_t fs, uint8_t bits_per_sample,
+                uint16_t ratio) {
     uint32_t mclk = fs * ratio;
-    resetChip();
-    delayMs(5);
-
-    if (!setSysClock(mclk)) return false;
-
-    if (!configureAudio(fs, mclk, bits_per_sample)) return false;
-
-    if (!setI2SFormat(I2S_STD, NORMAL_BCLK)) return false;
-
-    // ***********Analog + ALC + Vref Config ***********
-    initRegisters();
-
-    // Wait for analog to settle
-    delayMs(50);
+    switch (step) {
+      case 0:
+        AD_LOGI("[NAU8325] beginDynamic() starting...");
+        AD_LOGI("  fs = %lu Hz", fs);
+        AD_LOGI("  ratio = %u Hz", ratio);
+        AD_LOGI("  bits = %u", bits_per_sample);
+
+        if (bits_per_sample != 16 && bits_per_sample != 24 &&
+            bits_per_sample != 32) {
+          AD_LOGI("[NAU8325] Unsupported bit width: %u\n", bits_per_sample);
+          return STEP_FAILED;
+        }
 
-    // Enable Analog/Output Blocks (DAPM Equivalent)
-    enableDAPMBlocks();
+        set_ratio = ratio;
+        // resetChip()
+        writeRegister(0x0000, 0x0001);
+        return 2;
+      case 1:
+        writeRegister(0x0000, 0x0000);
+        return 2 + 5;
+      case 2:
+        if (!setSysClock(mclk)) return STEP_FAILED;
 
-    // Set default volume AFTER analog path is ready
-    setVolume(0xFD, 0xFD);
+        if (!configureAudio(fs, mclk, bits_per_sample)) return STEP_FAILED;
 
-    softMute(false);
+        if (!setI2SFormat(I2S_STD, NORMAL_BCLK)) return STEP_FAILED;
 
-    /*default powerOn*/
-    powerOn();
+        // ***********Analog + ALC + Vref Config ***********
+        initRegisters();
 
-    AD_LOGI("[NAU8325] beginDynamic() complete - sound should play");
-    return true;
+        // Wait for analog to settle
+        return 50;
+      case 3:
+        // Enable Analog/Output Blocks (DAPM Equivalent)
+        enableDAPMBlocks();
+
+        // Set default volume AFTER analog path is ready
+        setVolume(0xFD, 0xFD);
+
+        writeSoftMute(false);
+        return 30;
+      case 4:
+        /*default powerOn*/
+        writeSoftMute(false);
+        return 30;
+      case 5:
+        writePowerOn();
+        return 30;
+      default:
+        AD_LOGI("[NAU8325] beginDynamic() complete - sound should play");
+        return STEP_DONE;
+    }
   }
 
   /// Initializes the codec with sample rate and bit depth; uses default MCLK/FS ratio of 256
@@ -516,15 +539,25 @@ class NAU8325 {
 
   /// Enables or disables soft mute on the DAC output
   void softMute(bool enable) {
-    writeRegisterBits(NAU8325_R12_MUTE_CTRL, NAU8325_SOFT_MUTE,
-                      enable ? NAU8325_SOFT_MUTE : 0);
+    writeSoftMute(enable);
     delayMs(30);
   }
 
   /// Powers on the analog and DAC blocks and unmutes the output
   void powerOn() {
     softMute(false);
+    writePowerOn();
+    delayMs(30);
+  }
 
+  /// Sets the soft mute bit w/o waiting for the ramp
+  void writeSoftMute(bool enable) {
+    writeRegisterBits(NAU8325_R12_MUTE_CTRL, NAU8325_SOFT_MUTE,
+                      enable ? NAU8325_SOFT_MUTE : 0);
+  }
+
+  /// Enables the analog and DAC blocks w/o waiting for them to settle
+  void writePowerOn() {
     writeRegisterBits(
         NAU8325_R61_ANALOG_CONTROL_1,
         NAU8325_DACEN_MASK | NAU8325_DACCLKEN_MASK | NAU8325_DACEN_R_MASK |
@@ -536,8 +569,6 @@ class NAU8325 {
             (3 << NAU8325_BIASEN_SFT) | 0x03);  // VMID_EN
 
     setPowerUpDefault(true);
-
-    delayMs(30);
   }
 
   /// Powers off the analog and DAC blocks after soft-muting the output
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "Codecs/ZephyrDriverCommon.h"
+#include "Platforms/I2CBurstWriter.h"
 
 namespace audio_driver {
 
@@ -56,6 +57,10 @@ class PCM1681 : public ZephyrDriverCommon {
  public:
   static constexpr int N_CHANNELS = 8;
   static constexpr int N_REGISTERS = 20;
+  /// The register address is incremented during a multi byte write
+  static constexpr I2CBurstTrait burstTrait() {
+    return I2CBurstTrait(true, 0, I2C_MAX_BURST);
+  }
 
   // ---- Register addresses ----
   enum Reg : uint8_t {
@@ -283,12 +288,13 @@ class PCM1681 : public ZephyrDriverCommon {
   /// Write the full local register shadow to the device (skips registers
   /// that are not writeable: REG_0, REG_14 and REG_15)
   bool applyProperties() {
-    bool rc = true;
+    assert(wire != nullptr);
+    I2CBurstWriter writer(wire, i2c_addr, burstTrait());
     for (uint8_t reg = 0; reg < N_REGISTERS; reg++) {
       if (!isWriteable(reg)) continue;
-      rc &= writeReg(reg, reg_map[reg]);
+      writer.write(reg, reg_map[reg]);
     }
-    return rc;
+    return writer.flush() == RESULT_OK;
   }
 
  protected:
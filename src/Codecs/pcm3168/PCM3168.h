@@ -198,8 +198,8 @@ class PCM3168 {
   bool write(uint32_t address, const void* data, uint32_t len) {
     assert(wire != nullptr);
     uint8_t reg = static_cast<uint8_t>(address);
-    return i2c_bus_write_bytes(wire, i2c_addr, &reg, 1, (uint8_t*)data,
-                               len) == 0;
+    I2CIoVec iov[2] = {{&reg, 1}, {data, len}};
+    return i2c_bus_writev(wire, i2c_addr, iov, 2) == 0;
   }
 };
 
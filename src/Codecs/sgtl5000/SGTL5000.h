@@ -11,6 +11,7 @@
 #include "DriverCommon.h"
 #include "Platforms/API_Delay.h"
 #include "Platforms/API_I2C.h"
+#include "Platforms/RegScript.h"
 #include "stdbool.h"
 
 namespace audio_driver {
@@ -71,6 +72,9 @@ class SGTL5000 {
     I2SModePcm = 0x2,
   };
 
+  /// Upper limit of the register addresses (DAP registers included)
+  static constexpr int SGTL5000_REG_COUNT = 0x0140;
+
   SGTL5000() = default;
 
   /// Defines the I2C bus instance to be used
@@ -87,35 +91,10 @@ class SGTL5000 {
     }
     initialized = true;
 
-    // VDDD is externally driven (typical for the common breakout boards)
-    writeReg(Reg::AnaPower, 0x4060);
-    // VDDA & VDDIO both over 3.1V
-    writeReg(Reg::LinregCtrl, 0x006C);
-    // VAG=1.575V, normal ramp, +12.5% bias current
-    writeReg(Reg::RefCtrl, 0x01F2);
-    // LO_VAGCNTRL=1.65V, OUT_CURRENT=0.54mA
-    writeReg(Reg::LineOutCtrl, 0x0F22);
-    // allow up to 125mA on the short detectors
-    writeReg(Reg::ShortCtrl, 0x4446);
     // enable zero cross detectors
     ana_ctrl = 0x0137;
-    writeReg(Reg::AnaCtrl, ana_ctrl);
-
-    // power up lineout, headphone, adc, dac
-    writeReg(Reg::AnaPower, 0x40FF);
-    // power up all digital blocks (I2S in/out, DAC, ADC, DAP)
-    writeReg(Reg::DigPower, 0x0073);
-    delayMs(400);
-
-    // default line out level ~1.3Vp-p
-    writeReg(Reg::LineOutVol, 0x1D1D);
-
-    // route I2S_IN -> DAC and ADC -> I2S_OUT
-    writeReg(Reg::SssCtrl, 0x0010);
-    // unmute the DAC
-    writeReg(Reg::AdcDacCtrl, 0x0000);
-    // digital gain 0dB
-    writeReg(Reg::DacVol, 0x3C3C);
+    const uint16_t args[] = {ana_ctrl};
+    reg_script_run(scriptBus(), initScript(), args);
 
     // configure the digital audio interface and sample rate
     configI2S(CODEC_MODE_BOTH, &cfg->i2s);
@@ -241,6 +220,11 @@ class SGTL5000 {
     return i2c_bus_write_bytes(i2c_handle, i2c_addr, addr_bytes, 2, data, 2);
   }
 
+  /// @brief Write a list of 16 bit registers in one batch
+  error_t writeRegs(const RegWrite* list, int n) {
+    return i2c_bus_write_batch(i2c_handle, i2c_addr, list, n, 2, 2);
+  }
+
   /**
    * @brief Determine the CLK_CTRL register value for the requested sample
    * rate.
@@ -273,6 +257,60 @@ class SGTL5000 {
   bool initialized = false;
   uint16_t ana_ctrl = 0;
   int voice_volume = 70;
+
+  /// power up and routing: args[0] is the ANA_CTRL value
+  static const RegStep* initScript() {
+    static constexpr RegStep script[] = {
+        // VDDD is externally driven (typical for the common breakout boards)
+        script_write((uint16_t)Reg::AnaPower, 0x4060),
+        // VDDA & VDDIO both over 3.1V
+        script_write((uint16_t)Reg::LinregCtrl, 0x006C),
+        // VAG=1.575V, normal ramp, +12.5% bias current
+        script_write((uint16_t)Reg::RefCtrl, 0x01F2),
+        // LO_VAGCNTRL=1.65V, OUT_CURRENT=0.54mA
+        script_write((uint16_t)Reg::LineOutCtrl, 0x0F22),
+        // allow up to 125mA on the short detectors
+        script_write((uint16_t)Reg::ShortCtrl, 0x4446),
+        script_write_arg((uint16_t)Reg::AnaCtrl, 0),
+        // power up lineout, headphone, adc, dac
+        script_write((uint16_t)Reg::AnaPower, 0x40FF),
+        // power up all digital blocks (I2S in/out, DAC, ADC, DAP)
+        script_write((uint16_t)Reg::DigPower, 0x0073),
+        // VAG ramp
+        script_delay(400),
+        // default line out level ~1.3Vp-p
+        script_write((uint16_t)Reg::LineOutVol, 0x1D1D),
+        // route I2S_IN -> DAC and ADC -> I2S_OUT
+        script_write((uint16_t)Reg::SssCtrl, 0x0010),
+        // unmute the DAC
+        script_write((uint16_t)Reg::AdcDacCtrl, 0x0000),
+        // digital gain 0dB
+        script_write((uint16_t)Reg::DacVol, 0x3C3C),
+        script_end(),
+    };
+    static_assert(reg_script_valid(script, SGTL5000_REG_COUNT, 2, 1),
+                  "SGTL5000 initScript()");
+    return script;
+  }
+
+  /// Register access of the scripts: there is no register cache
+  RegScriptBus scriptBus() {
+    RegScriptBus bus;
+    bus.ref = this;
+    bus.write_batch = [](void* ref, const RegWrite* list, int n) {
+      return ((SGTL5000*)ref)->writeRegs(list, n);
+    };
+    bus.update = [](void* ref, uint16_t reg, uint16_t mask, uint16_t value) {
+      SGTL5000* self = (SGTL5000*)ref;
+      uint16_t current = self->readReg((Reg)reg);
+      return self->writeReg((Reg)reg, (current & ~mask) | (value & mask));
+    };
+    bus.read = [](void* ref, uint16_t reg, uint16_t* value) {
+      *value = ((SGTL5000*)ref)->readReg((Reg)reg);
+      return (error_t)RESULT_OK;
+    };
+    return bus;
+  }
 };
 
 }  // namespace audio_driver
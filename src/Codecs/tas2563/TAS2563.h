@@ -9,6 +9,8 @@
 #pragma once
 
 #include "Codecs/ZephyrDriverCommon.h"
+#include "Platforms/I2CPagedRegs.h"
+#include "Platforms/RegStream.h"
 
 namespace audio_driver {
 
@@ -272,8 +274,13 @@ class TAS2563 : public ZephyrDriverCommon {
     return rc;
   }
 
-  /// Software reset (TAS2563_SW_RESET register)
-  bool softReset() { return writeReg(REG_SW_RESET, SW_RESET_BIT); }
+  /// Software reset (TAS2563_SW_RESET register): book 0 / page 0 is selected
+  /// afterwards
+  bool softReset() {
+    if (!writeReg(REG_SW_RESET, SW_RESET_BIT)) return false;
+    i2c_bus_set_page(wire, i2c_addr, 0, 0);
+    return true;
+  }
 
   /// Read the chip revision / product ID register
   bool getRevisionId(uint8_t& rev_id) { return readReg(REG_REV_ID, rev_id); }
@@ -366,11 +373,27 @@ class TAS2563 : public ZephyrDriverCommon {
                       (uint8_t)TAS2563PowerMode::Shutdown);
   }
 
-  /// Set the active register page (only Page 0 is defined by this driver)
-  bool selectPage(uint8_t page) { return writeReg(REG_PAGE, page); }
+  /// Loads a tuning profile that was compiled with tools/regstream (e.g. the
+  /// PPC3 output with --page-reg 0x00 --book-reg 0x7f --reset-reg 0x01)
+  bool loadStream(const uint8_t* stream, size_t len) {
+    // the page may have been changed w/o page tracking (e.g. by a reset)
+    i2c_bus_invalidate_page(wire, i2c_addr);
+    return reg_stream_run(wire, i2c_addr, stream, len) == RESULT_OK;
+  }
 
-  /// Set the active register book (only Book 0 is defined by this driver)
-  bool selectBook(uint8_t book) { return writeReg(REG_BOOK, book); }
+  /// Set the active register page (only Page 0 is defined by this driver):
+  /// the write is skipped if the page is already selected
+  bool selectPage(uint8_t page) {
+    return i2c_bus_select_page(wire, i2c_addr, REG_PAGE, page) == RESULT_OK;
+  }
+
+  /// Set the active register book (only Book 0 is defined by this driver):
+  /// page 0 is selected first and the write is skipped if the book is
+  /// already selected
+  bool selectBook(uint8_t book) {
+    return i2c_bus_select_book(wire, i2c_addr, REG_PAGE, REG_BOOK, book) ==
+           RESULT_OK;
+  }
 };
 
 }  // namespace audio_driver
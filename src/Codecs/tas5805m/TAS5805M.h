@@ -28,6 +28,10 @@
 #include "DriverCommon.h"
 #include "Codecs/CodecConstants.h"
 #include "Platforms/API_I2C.h"
+#include "Platforms/I2CBurstWriter.h"
+#include "Platforms/RegMap.h"
+#include "Platforms/RegScript.h"
+#include "Platforms/RegStream.h"
 #include "Platforms/API_Delay.h"
 #include "Platforms/GPIO.h"
 #include "tas5805m_reg_cfg.h"
@@ -44,6 +48,7 @@ namespace audio_driver {
 class TAS5805M {
  public:
   static constexpr uint8_t TAS5805M_REG_00 = 0x00;
+  static constexpr uint8_t TAS5805M_REG_01 = 0x01;
   static constexpr uint8_t TAS5805M_REG_02 = 0x02;
   static constexpr uint8_t TAS5805M_REG_03 = 0x03;
   static constexpr uint8_t TAS5805M_REG_24 = 0x24;
@@ -55,6 +60,16 @@ class TAS5805M {
   static constexpr uint8_t TAS5805M_REG_2A = 0x2a;
   static constexpr uint8_t TAS5805M_REG_2B = 0x2b;
   static constexpr uint8_t TAS5805M_REG_35 = 0x35;
+  static constexpr uint8_t TAS5805M_FS_MON = 0x37;
+  static constexpr uint8_t TAS5805M_BCK_MON = 0x38;
+  static constexpr uint8_t TAS5805M_CLKDET_STATUS = 0x39;
+  static constexpr uint8_t TAS5805M_POWER_STATE = 0x68;
+  static constexpr uint8_t TAS5805M_AUTOMUTE_STATE = 0x69;
+  static constexpr uint8_t TAS5805M_CHAN_FAULT = 0x70;
+  static constexpr uint8_t TAS5805M_GLOBAL_FAULT1 = 0x71;
+  static constexpr uint8_t TAS5805M_GLOBAL_FAULT2 = 0x72;
+  static constexpr uint8_t TAS5805M_WARNING = 0x73;
+  static constexpr uint8_t TAS5805M_FAULT_CLEAR = 0x78;
   static constexpr uint8_t TAS5805M_REG_7E = 0x7e;
   static constexpr uint8_t TAS5805M_REG_7F = 0x7f;
   static constexpr uint8_t TAS5805M_PAGE_00 = 0x00;
@@ -68,6 +83,12 @@ class TAS5805M {
   static constexpr int TAS5805M_ADDR = 0x2E;
   static constexpr int TAS5805M_VOLUME_MAX = 100;
   static constexpr int TAS5805M_VOLUME_MIN = 0;
+  /// number of cached page 0 registers
+  static constexpr int TAS5805M_REG_COUNT = 0x80;
+  /// The register address is incremented within a page
+  static constexpr I2CBurstTrait burstTrait() {
+    return I2CBurstTrait(true, 0, I2C_MAX_BURST);
+  }
   TAS5805M() = default;
 
   /// Defines the I2C bus instance to be used
@@ -83,21 +104,37 @@ class TAS5805M {
 
   /// @brief Initialize TAS5805 codec chip
   error_t init(codec_config_t* codec_cfg) {
-    GPIO gpio;
-    error_t ret = RESULT_OK;
-    AD_LOGI("Power ON CODEC with GPIO %d", power_pin);
-    gpio.pinMode(power_pin, OUTPUT);
-    gpio.digitalWrite(power_pin, 0);
-    delayMs(20);
-    gpio.digitalWrite(power_pin, 1);
-    delayMs(20);
-
-    ret |= transmitRegisters(
-        tas5805m_registers,
-        sizeof(tas5805m_registers) / sizeof(tas5805m_registers[0]));
+    bool ok = run_steps([&](int step) { return initStep(step, codec_cfg); });
+    return ok ? RESULT_OK : RESULT_FAIL;
+  }
 
-    if (ret != 0) { AD_LOGE("Fail to iniitialize tas5805m PA"); return RESULT_FAIL; }
-    return ret;
+  /// Non-blocking init(): executes the indicated step and returns the delay
+  /// in ms before the next step, STEP_DONE or STEP_FAILED
+  int initStep(int step, codec_config_t* codec_cfg) {
+    GPIO gpio;
+    switch (step) {
+      case 0:
+        AD_LOGI("Power ON CODEC with GPIO %d", power_pin);
+        gpio.pinMode(power_pin, OUTPUT);
+        gpio.digitalWrite(power_pin, 0);
+        return 20;
+      case 1:
+        gpio.digitalWrite(power_pin, 1);
+        return 20;
+      default: {
+        // the delays of the table are executed as separate steps
+        if (step == 2) table_pos = 0;
+        int rc = reg_cfg_table_step(
+            i2c_handle, i2c_addr, burstTrait(), tas5805m_registers,
+            sizeof(tas5805m_registers) / sizeof(tas5805m_registers[0]),
+            table_pos);
+        // the table switches pages and books: we do not know the content
+        regs.invalidate();
+        i2c_bus_invalidate_page(i2c_handle, i2c_addr);
+        if (rc == STEP_FAILED) AD_LOGE("Fail to iniitialize tas5805m PA");
+        return rc;
+      }
+    }
   }
 
   /// @brief Deinitialize TAS5805 codec chip
@@ -118,26 +155,21 @@ class TAS5805M {
     }
     vol_idx = vol / 5;
 
-    uint8_t cmd[2] = {0, 0};
-    error_t ret = RESULT_OK;
-
-    cmd[0] = MASTER_VOL_REG_ADDR;
-    cmd[1] = tas5805m_volume[vol_idx];
-    ret = i2c_bus_write_bytes(i2c_handle, i2c_addr, &cmd[0], 1, &cmd[1], 1);
-    AD_LOGW("volume = 0x%x", cmd[1]);
+    uint8_t value = tas5805m_volume[vol_idx];
+    error_t ret = regs.write(MASTER_VOL_REG_ADDR, value);
+    AD_LOGW("volume = 0x%x", value);
     return ret;
   }
 
   /// @brief Get voice volume (0~100)
   error_t getVolume(int* value) {
     /// FIXME: Got the digit volume is not right.
-    uint8_t cmd[2] = {MASTER_VOL_REG_ADDR, 0x00};
-    error_t ret =
-        i2c_bus_read_bytes(i2c_handle, i2c_addr, &cmd[0], 1, &cmd[1], 1);
+    uint8_t reg = 0;
+    error_t ret = regs.read(MASTER_VOL_REG_ADDR, &reg);
     if (ret != 0) { AD_LOGE("Fail to get volume"); return RESULT_FAIL; }
     unsigned i;
     for (i = 0; i < sizeof(tas5805m_volume); i++) {
-      if (cmd[1] >= tas5805m_volume[i]) break;
+      if (reg >= tas5805m_volume[i]) break;
     }
     AD_LOGI("Volume is %d", i * 5);
     *value = 5 * i;
@@ -150,17 +182,7 @@ class TAS5805M {
    *        setMuteFade()
    */
   error_t setMute(bool enable) {
-    error_t ret = RESULT_OK;
-    uint8_t cmd[2] = {TAS5805M_REG_03, 0x00};
-    ret |= i2c_bus_read_bytes(i2c_handle, i2c_addr, &cmd[0], 1, &cmd[1], 1);
-
-    if (enable) {
-      cmd[1] |= 0x8;
-    } else {
-      cmd[1] &= (~0x08);
-    }
-    ret |= i2c_bus_write_bytes(i2c_handle, i2c_addr, &cmd[0], 1, &cmd[1], 1);
-
+    error_t ret = regs.update(TAS5805M_REG_03, 0x08, enable ? 0x08 : 0x00);
     if (ret != 0) { AD_LOGE("Fail to set mute"); return RESULT_FAIL; }
     return ret;
   }
@@ -201,7 +223,7 @@ class TAS5805M {
     }
     cmd[1] |= (cmd[1] << 4);
 
-    ret |= i2c_bus_write_bytes(i2c_handle, i2c_addr, &cmd[0], 1, &cmd[1], 1);
+    ret |= regs.write(cmd[0], cmd[1]);
     if (ret != 0) { AD_LOGE("Fail to set mute fade"); return RESULT_FAIL; }
     AD_LOGI("Set mute fade, value:%d, 0x%x", value, cmd[1]);
     return ret;
@@ -209,12 +231,10 @@ class TAS5805M {
 
   /// @brief Get TAS5805 mute status
   error_t getMute(int* value) {
-    error_t ret = RESULT_OK;
-    uint8_t cmd[2] = {TAS5805M_REG_03, 0x00};
-    ret |= i2c_bus_read_bytes(i2c_handle, i2c_addr, &cmd[0], 1, &cmd[1], 1);
-
+    uint8_t reg = 0;
+    error_t ret = regs.read(TAS5805M_REG_03, &reg);
     if (ret != 0) { AD_LOGE("Fail to get mute"); return RESULT_FAIL; }
-    *value = (cmd[1] & 0x08) >> 3;
+    *value = (reg & 0x08) >> 3;
     AD_LOGI("Get mute value: 0x%x", *value);
     return ret;
   }
@@ -224,10 +244,7 @@ class TAS5805M {
    * @param value  TAS5805M_DAMP_MODE_BTL or TAS5805M_DAMP_MODE_PBTL
    */
   error_t setDampMode(int value) {
-    unsigned char cmd[2] = {0};
-    cmd[0] = TAS5805M_REG_02;
-    cmd[1] = 0x10 | value;
-    return i2c_bus_write_bytes(i2c_handle, i2c_addr, &cmd[0], 1, &cmd[1], 1);
+    return regs.write(TAS5805M_REG_02, 0x10 | value);
   }
 
   /// @brief Control TAS5805 codec chip
@@ -242,43 +259,33 @@ class TAS5805M {
     return RESULT_OK;
   }
 
-  error_t transmitRegisters(const tas5805m_cfg_reg_t* conf_buf, int size) {
-    int i = 0;
-    error_t ret = RESULT_OK;
-    while (i < size) {
-      switch (conf_buf[i].offset) {
-        case CFG_META_SWITCH:
-          // Used in legacy applications.  Ignored here.
-          break;
-        case CFG_META_DELAY:
-          delayMs(conf_buf[i].value);
-          break;
-        case CFG_META_BURST:
-          ret = i2c_bus_write_bytes(i2c_handle, i2c_addr,
-                                    (unsigned char*)(&conf_buf[i + 1].offset), 1,
-                                    (unsigned char*)(&conf_buf[i + 1].value),
-                                    conf_buf[i].value);
-          i += (conf_buf[i].value / 2) + 1;
-          break;
-        case CFG_END_1:
-          if (CFG_END_2 == conf_buf[i + 1].offset &&
-              CFG_END_3 == conf_buf[i + 2].offset) {
-            AD_LOGI("End of tms5805m reg: %d", i);
-          }
-          break;
-        default:
-          ret = i2c_bus_write_bytes(i2c_handle, i2c_addr,
-                                    (unsigned char*)(&conf_buf[i].offset), 1,
-                                    (unsigned char*)(&conf_buf[i].value), 1);
-          break;
-      }
-      i++;
+  /// Sends a tuning profile that was compiled with tools/regstream (e.g.
+  /// after init()): the stream can be in flash or a memory mapped file
+  error_t transmitStream(const uint8_t* stream, size_t len) {
+    // the page may have been changed by a table w/o page tracking
+    i2c_bus_invalidate_page(i2c_handle, i2c_addr);
+    error_t ret = reg_stream_run(i2c_handle, i2c_addr, stream, len);
+    // the stream switches pages and books: we do not know the content anymore
+    regs.invalidate();
+    if (ret != RESULT_OK) {
+      AD_LOGE("Fail to load the register stream to tas5805m");
+      return RESULT_FAIL;
     }
+    return ret;
+  }
+
+  /// Sends the configuration table: consecutive register entries are
+  /// combined into bursts
+  error_t transmitRegisters(const tas5805m_cfg_reg_t* conf_buf, int size) {
+    error_t ret =
+        reg_cfg_table_run(i2c_handle, i2c_addr, burstTrait(), conf_buf, size);
+    // the table switches pages and books: we do not know the content anymore
+    regs.invalidate();
+    i2c_bus_invalidate_page(i2c_handle, i2c_addr);
     if (ret != RESULT_OK) {
       AD_LOGE("Fail to load configuration to tas5805m");
       return RESULT_FAIL;
     }
-    AD_LOGI("%s:  write %d reg done", __FUNCTION__, i);
     return ret;
   }
 
@@ -286,6 +293,47 @@ class TAS5805M {
   i2c_bus_handle_t i2c_handle = nullptr;
   int i2c_addr = TAS5805M_ADDR;
   GpioPin power_pin{};
+  /// position in the configuration table of initStep()
+  int table_pos = 0;
+  /// page/book selection, self clearing and status registers of page 0
+  struct RegInfo {
+    static uint8_t flags(size_t reg) {
+      static constexpr RegDesc reg_desc[] = {
+          {TAS5805M_REG_00, REG_VOLATILE},  // page select
+          {TAS5805M_REG_01, REG_VOLATILE},  // self clearing resets
+          {TAS5805M_FS_MON, REG_VOLATILE | REG_READ_ONLY},
+          {TAS5805M_BCK_MON, REG_VOLATILE | REG_READ_ONLY},
+          {TAS5805M_CLKDET_STATUS, REG_VOLATILE | REG_READ_ONLY},
+          {TAS5805M_POWER_STATE, REG_VOLATILE | REG_READ_ONLY},
+          {TAS5805M_AUTOMUTE_STATE, REG_VOLATILE | REG_READ_ONLY},
+          {TAS5805M_CHAN_FAULT, REG_VOLATILE | REG_READ_ONLY},
+          {TAS5805M_GLOBAL_FAULT1, REG_VOLATILE | REG_READ_ONLY},
+          {TAS5805M_GLOBAL_FAULT2, REG_VOLATILE | REG_READ_ONLY},
+          {TAS5805M_WARNING, REG_VOLATILE | REG_READ_ONLY},
+          {TAS5805M_FAULT_CLEAR, REG_VOLATILE},
+          {TAS5805M_REG_7F, REG_VOLATILE},  // book select
+      };
+      static_assert(reg_desc_valid(reg_desc, TAS5805M_REG_COUNT),
+                    "TAS5805M reg_desc");
+      return reg_desc_flags(reg_desc, reg);
+    }
+  };
+  /// shadow copy of the book 0 / page 0 control registers: only used for
+  /// the registers that are accessed w/o page switching
+  RegMap<uint8_t, uint8_t, TAS5805M_REG_COUNT, RegInfo> regs{
+      this, busWrite, busRead};
+
+  static error_t busWrite(void* ref, uint8_t reg, uint8_t value) {
+    TAS5805M* self = (TAS5805M*)ref;
+    return i2c_bus_write_bytes(self->i2c_handle, self->i2c_addr, &reg, 1,
+                               &value, 1);
+  }
+
+  static error_t busRead(void* ref, uint8_t reg, uint8_t* value) {
+    TAS5805M* self = (TAS5805M*)ref;
+    return i2c_bus_read_bytes(self->i2c_handle, self->i2c_addr, &reg, 1,
+                              value, 1);
+  }
 };
 
 } // namespace audio_driver
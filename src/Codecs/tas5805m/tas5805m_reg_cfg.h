@@ -26,25 +26,18 @@
 
 #pragma once
 
-namespace audio_driver {
+#include "Platforms/RegScript.h"
 
-static constexpr uint8_t CFG_META_SWITCH = 255;
-static constexpr uint8_t CFG_META_DELAY = 254;
-static constexpr uint8_t CFG_META_BURST = 253;
-static constexpr uint8_t CFG_END_1 = 0xaa;
-static constexpr uint8_t CFG_END_2 = 0xcc;
-static constexpr uint8_t CFG_END_3 = 0xee;
+namespace audio_driver {
 
-struct tas5805m_cfg_reg_t {
-  uint8_t offset;
-  uint8_t value;
-};
+/// PPC3 table entry (see RegCfgEntry and CFG_META_...)
+using tas5805m_cfg_reg_t = RegCfgEntry;
 
 static const uint8_t tas5805m_volume[] = {
     0xff, 0x9f, 0x8f, 0x7f, 0x6f, 0x5f, 0x5c, 0x5a, 0x58, 0x54, 0x50,
     0x4c, 0x4a, 0x48, 0x44, 0x40, 0x3d, 0x3b, 0x39, 0x37, 0x35};
 
-static const tas5805m_cfg_reg_t tas5805m_registers[] = {
+static constexpr tas5805m_cfg_reg_t tas5805m_registers[] = {
     // RESET
     {0x00, 0x00},
     {0x7f, 0x00},
@@ -1736,5 +1729,6 @@ static const tas5805m_cfg_reg_t tas5805m_registers[] = {
     {0x78, 0x80},
 
 };
+static_assert(reg_cfg_table_valid(tas5805m_registers), "tas5805m_registers");
 
 }  // namespace audio_driver
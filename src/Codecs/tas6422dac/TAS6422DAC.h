@@ -10,6 +10,7 @@
 #pragma once
 
 #include "Codecs/ZephyrDriverCommon.h"
+#include "Platforms/RegMap.h"
 
 namespace audio_driver {
 
@@ -71,6 +72,7 @@ class TAS6422DAC : public ZephyrDriverCommon {
     MISC_CTRL_4_ADDR = 0x26,
     MISC_CTRL_5_ADDR = 0x28,
   };
+  static constexpr int REG_COUNT = MISC_CTRL_5_ADDR + 1;
 
   // ---- Mode Control Register bits ----
   static constexpr uint8_t MODE_CTRL_RESET = (1u << 7);
@@ -331,9 +333,37 @@ class TAS6422DAC : public ZephyrDriverCommon {
   /// Read the warnings register (POR / over-temperature warnings)
   bool getWarnings(uint8_t& value) { return readReg(WARNINGS_ADDR, value); }
 
+  /// Logs all registers that can be read w/o side effects
+  void readAll() {
+    for (int reg = 0; reg < REG_COUNT; reg++) {
+      if (RegInfo::flags(reg) & (REG_WRITE_ONLY | REG_PRECIOUS)) continue;
+      uint8_t value = 0;
+      readReg(reg, value);
+      AD_LOGI("REG:%02x, %02x", reg, value);
+    }
+  }
+
  protected:
   /// Output device selection set via setDevices(), used by configureOutput()
   output_device_t output_device = DAC_OUTPUT_ALL;
+  /// self clearing, report and fault registers
+  struct RegInfo {
+    static uint8_t flags(size_t reg) {
+      static constexpr RegDesc reg_desc[] = {
+          {MODE_CTRL_ADDR, REG_VOLATILE},  // self clearing reset
+          {DC_LDG_REPORT_1_ADDR, REG_VOLATILE | REG_READ_ONLY},
+          {DC_LDG_REPORT_3_ADDR, REG_VOLATILE | REG_READ_ONLY},
+          {CH_FAULTS_ADDR, REG_VOLATILE | REG_READ_ONLY},
+          {GLOBAL_FAULTS_1_ADDR, REG_VOLATILE | REG_READ_ONLY},
+          {GLOBAL_FAULTS_2_ADDR, REG_VOLATILE | REG_READ_ONLY},
+          {WARNINGS_ADDR, REG_VOLATILE | REG_READ_ONLY},
+          {MISC_CTRL_3_ADDR, REG_VOLATILE},  // self clearing clear fault
+          {ILIMIT_STATUS_ADDR, REG_VOLATILE | REG_READ_ONLY},
+      };
+      static_assert(reg_desc_valid(reg_desc, REG_COUNT), "TAS6422 reg_desc");
+      return reg_desc_flags(reg_desc, reg);
+    }
+  };
 };
 
 }  // namespace audio_driver
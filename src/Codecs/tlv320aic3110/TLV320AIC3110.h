@@ -12,6 +12,7 @@
 #include <cstddef>
 
 #include "Codecs/ZephyrDriverCommon.h"
+#include "Platforms/I2CPagedRegs.h"
 
 namespace audio_driver {
 
@@ -296,8 +297,12 @@ class TLV320AIC3110 : public ZephyrDriverCommon {
     return rc;
   }
 
-  /// Soft reset of the codec
-  bool softReset() { return writePagedReg(SOFT_RESET_ADDR, SOFT_RESET_ASSERT); }
+  /// Soft reset of the codec: page 0 is selected afterwards
+  bool softReset() {
+    if (!writePagedReg(SOFT_RESET_ADDR, SOFT_RESET_ASSERT)) return false;
+    i2c_bus_set_page(wire, i2c_addr, 0, 0);
+    return true;
+  }
 
   /// Configure the digital audio interface (I2S) word size and clock direction
   bool configureDai(uint8_t word_size, bool bclk_master, bool wclk_master) {
@@ -346,17 +351,19 @@ class TLV320AIC3110 : public ZephyrDriverCommon {
     }
     if (entry == nullptr) return false;
 
-    bool rc = true;
     uint8_t p = entry->pll_p;
     uint8_t r = 1;
     uint8_t j = entry->pll_j;
     uint16_t d = entry->pll_d;
+    // the writes are grouped by page and sent as bursts
+    I2CPagedWriter writer(wire, i2c_addr, PAGE_CONTROL_ADDR, burstTrait());
 
     /* set the PLL dividers */
-    rc &= writePagedReg(PLL_P_R_ADDR, (uint8_t)((1 << 7) | PLL_P(p) | PLL_R(r)));
-    rc &= writePagedReg(PLL_J_ADDR, j);
-    rc &= writePagedReg(PLL_D_MSB_ADDR, (uint8_t)(d >> 8));
-    rc &= writePagedReg(PLL_D_LSB_ADDR, (uint8_t)(d & 0xFF));
+    uint8_t pll_p_r = (uint8_t)((1 << 7) | PLL_P(p) | PLL_R(r));
+    writePagedReg(writer, PLL_P_R_ADDR, pll_p_r);
+    writePagedReg(writer, PLL_J_ADDR, j);
+    writePagedReg(writer, PLL_D_MSB_ADDR, (uint8_t)(d >> 8));
+    writePagedReg(writer, PLL_D_LSB_ADDR, (uint8_t)(d & 0xFF));
 
     uint8_t madc = entry->madc;
     uint8_t nadc = entry->nadc;
@@ -369,36 +376,37 @@ class TLV320AIC3110 : public ZephyrDriverCommon {
     if (bclk_master) {
       bclk_div = (dosr * mdac) / (word_size * 2U); /* stereo */
       if ((bclk_div * word_size * 2) != (dosr * mdac)) return false;
-      rc &= writePagedReg(BCLK_DIV_ADDR,
-                           (uint8_t)(BCLK_DIV_POWER_UP | BCLK_DIV((uint8_t)bclk_div)));
+      writePagedReg(writer, BCLK_DIV_ADDR,
+                    (uint8_t)(BCLK_DIV_POWER_UP | BCLK_DIV((uint8_t)bclk_div)));
     }
 
-    /* Set clock gen mux and turn on PLL */
-    rc &= writePagedReg(CLOCK_GEN_MUX_ADDR, CLOCK_GEN_MUX_DEFAULT);
-    rc &= updatePagedReg(PLL_P_R_ADDR, PLL_POWER_UP, PLL_POWER_UP);
+    /* Set clock gen mux and turn on PLL (the P/R value is known, so no
+     * read-modify-write is needed) */
+    writePagedReg(writer, CLOCK_GEN_MUX_ADDR, CLOCK_GEN_MUX_DEFAULT);
+    writePagedReg(writer, PLL_P_R_ADDR, (uint8_t)(pll_p_r | PLL_POWER_UP));
 
     /* set NDAC, then MDAC, followed by OSR */
-    rc &= writePagedReg(NDAC_DIV_ADDR, (uint8_t)(NDAC_DIV(ndac) | NDAC_POWER_UP));
-    rc &= writePagedReg(MDAC_DIV_ADDR, (uint8_t)(MDAC_DIV(mdac) | MDAC_POWER_UP));
-    rc &= writePagedReg(OSR_MSB_ADDR, (uint8_t)((dosr >> 8) & OSR_MSB_MASK));
-    rc &= writePagedReg(OSR_LSB_ADDR, (uint8_t)(dosr & OSR_LSB_MASK));
+    writePagedReg(writer, NDAC_DIV_ADDR, (uint8_t)(NDAC_DIV(ndac) | NDAC_POWER_UP));
+    writePagedReg(writer, MDAC_DIV_ADDR, (uint8_t)(MDAC_DIV(mdac) | MDAC_POWER_UP));
+    writePagedReg(writer, OSR_MSB_ADDR, (uint8_t)((dosr >> 8) & OSR_MSB_MASK));
+    writePagedReg(writer, OSR_LSB_ADDR, (uint8_t)(dosr & OSR_LSB_MASK));
 
     /* set NADC, MADC, OSR */
-    rc &= writePagedReg(NADC_DIV_ADDR, (uint8_t)(NADC_DIV(nadc) | NADC_POWER_UP));
-    rc &= writePagedReg(MADC_DIV_ADDR, (uint8_t)(MADC_DIV(madc) | MADC_POWER_UP));
-    rc &= writePagedReg(AOSR_ADDR, aosr);
+    writePagedReg(writer, NADC_DIV_ADDR, (uint8_t)(NADC_DIV(nadc) | NADC_POWER_UP));
+    writePagedReg(writer, MADC_DIV_ADDR, (uint8_t)(MADC_DIV(madc) | MADC_POWER_UP));
+    writePagedReg(writer, AOSR_ADDR, aosr);
 
     if (bclk_master) {
-      rc &= writePagedReg(BCLK_DIV_ADDR,
-                           (uint8_t)(BCLK_DIV((uint8_t)bclk_div) | BCLK_DIV_POWER_UP));
+      writePagedReg(writer, BCLK_DIV_ADDR,
+                    (uint8_t)(BCLK_DIV((uint8_t)bclk_div) | BCLK_DIV_POWER_UP));
     }
 
     /* calculate MCLK divider to get ~1MHz and setup the timer clock */
     uint8_t mclk_div = (uint8_t)((mclk + 999999U) / 1000000U);
-    rc &= writePagedReg(TIMER_MCLK_DIV_ADDR,
-                         (uint8_t)(TIMER_MCLK_DIV_EN_EXT | TIMER_MCLK_DIV_VAL(mclk_div)));
+    writePagedReg(writer, TIMER_MCLK_DIV_ADDR,
+                  (uint8_t)(TIMER_MCLK_DIV_EN_EXT | TIMER_MCLK_DIV_VAL(mclk_div)));
 
-    return rc;
+    return writer.flush() == RESULT_OK;
   }
 
   /// Select the DAC/ADC decimation filter (processing block) based on sample rate
@@ -611,27 +619,35 @@ class TLV320AIC3110 : public ZephyrDriverCommon {
   }
 
  protected:
-  uint8_t current_page = 0xFF;  ///< cached page, invalid initially
   /// Output device selection set via setDevices(), used by configureOutput()
   output_device_t output_device = DAC_OUTPUT_ALL;
+  /// The register address is incremented within a page
+  static constexpr I2CBurstTrait burstTrait() {
+    return I2CBurstTrait(true, 0, I2C_MAX_BURST);
+  }
 
-  /// Selects the active register page (writes register 0 of page 0)
+  /// Selects the active register page (writes register 0 of page 0): the
+  /// selected page is tracked per device, so redundant selects are skipped
   bool selectPage(uint8_t page) {
-    if (current_page == page) return true;
-    uint8_t reg = PAGE_CONTROL_ADDR;
-    if (!writeReg(reg, page)) return false;
-    current_page = page;
-    return true;
+    return i2c_bus_select_page(wire, i2c_addr, PAGE_CONTROL_ADDR, page) ==
+           RESULT_OK;
   }
 
   /// Writes a register on the given page
   bool writePagedReg(RegAddr reg, uint8_t value) {
+    I2CTransaction transaction(wire);
     if (!selectPage(reg.page)) return false;
     return writeReg(reg.reg, value);
   }
 
+  /// Queues a register write: it is sent by I2CPagedWriter::flush()
+  void writePagedReg(I2CPagedWriter& writer, RegAddr reg, uint8_t value) {
+    writer.write(reg.page, reg.reg, value);
+  }
+
   /// Reads a register on the given page
   bool readPagedReg(RegAddr reg, uint8_t& value) {
+    I2CTransaction transaction(wire);
     if (!selectPage(reg.page)) return false;
     return readReg(reg.reg, value);
   }
@@ -639,6 +655,7 @@ class TLV320AIC3110 : public ZephyrDriverCommon {
   /// Read-Modify-Write of a register on the given page
   bool updatePagedReg(RegAddr reg, uint8_t mask, uint8_t value) {
     uint8_t old = 0;
+    I2CTransaction transaction(wire);
     if (!readPagedReg(reg, old)) return false;
     uint8_t updated = (old & ~mask) | (value & mask);
     if (updated == old) return true;
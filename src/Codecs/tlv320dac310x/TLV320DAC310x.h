@@ -13,6 +13,7 @@
 #include <math.h>
 
 #include "Codecs/ZephyrDriverCommon.h"
+#include "Platforms/I2CPagedRegs.h"
 
 namespace audio_driver {
 
@@ -233,8 +234,12 @@ class TLV320DAC310x : public ZephyrDriverCommon {
     return rc;
   }
 
-  /// Soft reset of the codec
-  bool softReset() { return writePagedReg(0, SOFT_RESET_ADDR, SOFT_RESET_ASSERT); }
+  /// Soft reset of the codec: page 0 is selected afterwards
+  bool softReset() {
+    if (!writePagedReg(0, SOFT_RESET_ADDR, SOFT_RESET_ASSERT)) return false;
+    i2c_bus_set_page(wire, i2c_addr, 0, 0);
+    return true;
+  }
 
   /**
    * @brief Configure NDAC/MDAC/OSR dividers (and optionally BCLK divider)
@@ -242,7 +247,6 @@ class TLV320DAC310x : public ZephyrDriverCommon {
    */
   bool configureClocks(uint32_t mclk_freq, uint32_t sample_rate,
                         bool bclk_controller = false, uint8_t word_size = 16) {
-    bool rc = true;
     uint32_t dac_clk, mod_clk;
     uint32_t ndac, mdac, bclk_div = 0;
     int osr, osr_min, osr_max;
@@ -287,29 +291,34 @@ class TLV320DAC310x : public ZephyrDriverCommon {
       if ((bclk_div * den) != num) {
         return false;
       }
-      rc &= writePagedReg(0, BCLK_DIV_ADDR,
-                           (uint8_t)(BCLK_DIV_POWER_UP | (bclk_div & BCLK_DIV_MASK)));
+    }
+
+    // the writes are grouped by page and sent as bursts
+    I2CPagedWriter writer(wire, i2c_addr, PAGE_CONTROL_ADDR, burstTrait());
+    if (bclk_controller) {
+      writer.write(0, BCLK_DIV_ADDR,
+                   (uint8_t)(BCLK_DIV_POWER_UP | (bclk_div & BCLK_DIV_MASK)));
     }
 
     /* set NDAC, then MDAC, followed by OSR */
-    rc &= writePagedReg(0, NDAC_DIV_ADDR,
-                         (uint8_t)((ndac & NDAC_DIV_MASK) | NDAC_POWER_UP_MASK));
-    rc &= writePagedReg(0, MDAC_DIV_ADDR,
-                         (uint8_t)((mdac & MDAC_DIV_MASK) | MDAC_POWER_UP_MASK));
-    rc &= writePagedReg(0, OSR_MSB_ADDR, (uint8_t)((osr >> 8) & OSR_MSB_MASK));
-    rc &= writePagedReg(0, OSR_LSB_ADDR, (uint8_t)(osr & OSR_LSB_MASK));
+    writer.write(0, NDAC_DIV_ADDR,
+                 (uint8_t)((ndac & NDAC_DIV_MASK) | NDAC_POWER_UP_MASK));
+    writer.write(0, MDAC_DIV_ADDR,
+                 (uint8_t)((mdac & MDAC_DIV_MASK) | MDAC_POWER_UP_MASK));
+    writer.write(0, OSR_MSB_ADDR, (uint8_t)((osr >> 8) & OSR_MSB_MASK));
+    writer.write(0, OSR_LSB_ADDR, (uint8_t)(osr & OSR_LSB_MASK));
 
     if (bclk_controller) {
-      rc &= writePagedReg(0, BCLK_DIV_ADDR,
-                           (uint8_t)((bclk_div & BCLK_DIV_MASK) | BCLK_DIV_POWER_UP));
+      writer.write(0, BCLK_DIV_ADDR,
+                   (uint8_t)((bclk_div & BCLK_DIV_MASK) | BCLK_DIV_POWER_UP));
     }
 
     /* MCLK divider for the internal timer, target ~1MHz */
     uint32_t mclk_div = (mclk_freq + 999999) / 1000000;
-    rc &= writePagedReg(3, TIMER_MCLK_DIV_ADDR,
-                         (uint8_t)(TIMER_MCLK_DIV_EN_EXT | (mclk_div & TIMER_MCLK_DIV_MASK)));
+    writer.write(3, TIMER_MCLK_DIV_ADDR,
+                 (uint8_t)(TIMER_MCLK_DIV_EN_EXT | (mclk_div & TIMER_MCLK_DIV_MASK)));
 
-    return rc;
+    return writer.flush() == RESULT_OK;
   }
 
   /// Configure the digital audio interface (format, word length, clock directions)
@@ -615,7 +624,6 @@ class TLV320DAC310x : public ZephyrDriverCommon {
   }
 
  protected:
-  uint8_t active_page = 0xFF;       ///< 0xFF forces a page select on first access
   uint32_t current_sample_rate = 44100;
   /// Output device selection set via setDevices(), used by configureOutput()
   output_device_t output_device = DAC_OUTPUT_ALL;
@@ -655,34 +663,41 @@ class TLV320DAC310x : public ZephyrDriverCommon {
     }
   }
 
+  /// The register address is incremented within a page
+  static constexpr I2CBurstTrait burstTrait() {
+    return I2CBurstTrait(true, 0, I2C_MAX_BURST);
+  }
+
   static TLV320DAC310xOsrMultiple getOsrMultiple(uint32_t sample_rate) {
     if (sample_rate >= 192000) return TLV320DAC310xOsrMultiple::Multiple2;
     if (sample_rate >= 96000) return TLV320DAC310xOsrMultiple::Multiple4;
     return TLV320DAC310xOsrMultiple::Multiple8;
   }
 
-  /// Select the active register page (cached, only writes if changed)
+  /// Select the active register page: the page is tracked per device, so
+  /// the write is skipped if it is unchanged
   bool selectPage(uint8_t page) {
-    if (active_page == page) return true;
-    if (!writeReg(PAGE_CONTROL_ADDR, page)) return false;
-    active_page = page;
-    return true;
+    return i2c_bus_select_page(wire, i2c_addr, PAGE_CONTROL_ADDR, page) ==
+           RESULT_OK;
   }
 
   /// Write a register on the given page
   bool writePagedReg(uint8_t page, uint8_t reg, uint8_t value) {
+    I2CTransaction transaction(wire);
     if (!selectPage(page)) return false;
     return writeReg(reg, value);
   }
 
   /// Read a register on the given page
   bool readPagedReg(uint8_t page, uint8_t reg, uint8_t& value) {
+    I2CTransaction transaction(wire);
     if (!selectPage(page)) return false;
     return readReg(reg, value);
   }
 
   /// Read-Modify-Write of a register on the given page
   bool updatePagedReg(uint8_t page, uint8_t reg, uint8_t mask, uint8_t value) {
+    I2CTransaction transaction(wire);
     if (!selectPage(page)) return false;
     return updateReg(reg, mask, value);
   }
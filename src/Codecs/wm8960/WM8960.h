@@ -37,6 +37,7 @@
 
 #include "DriverCommon.h"
 #include "Platforms/API_I2C.h"
+#include "Platforms/RegMap.h"
 
 #ifdef ARDUINO
 #include <Arduino.h>
@@ -341,7 +342,7 @@ struct _wm8960_operation_t {
  */
 class WM8960 {
  public:
-  WM8960() = default;
+  WM8960() { setDefaults(); }
 
   /// Defines the I2C bus instance to be used
   void setWire(i2c_bus_handle_t handle) { i2c_handle = handle; }
@@ -425,6 +426,46 @@ class WM8960 {
     enabled_features = WM8960_FEATURE_NONE;
   }
 
+  /**
+   * @brief Restores the configuration after a power cycle of the codec w/o
+   * running init() again: only the registers which differ from the power-on
+   * defaults are written.
+   *
+   * @return true if all registers could be written
+   */
+  bool resync() {
+    // the PLL (R52-R55) is set up before it is powered up (R25, R26) and
+    // selected as clock source (R4)
+    static const uint8_t last[] = {WM8960_REG_PWR_MGMT1, WM8960_REG_PWR_MGMT2,
+                                   WM8960_REG_CLK1, WM8960_REG_PWR_MGMT3};
+    I2CTransaction transaction(i2c_handle);
+    return regs.resync(last, sizeof(last)) == RESULT_OK;
+  }
+
+  /**
+   * @brief Serialises the register cache and the driver settings (see
+   * AudioDriver::saveState())
+   */
+  bool saveState(StateBlobWriter& out) {
+    out.put8(enabled_features);
+    out.put8(pll_enabled);
+    return regs.save(out) == RESULT_OK;
+  }
+
+  /**
+   * @brief Restores a state created by saveState() on a codec in its power-on
+   * state w/o running init() again: only the registers which differ from the
+   * power-on defaults are written.
+   */
+  bool restoreState(StateBlobReader& in) {
+    uint8_t features = in.get8();
+    bool pll = in.get8() != 0;
+    if (regs.load(in) != RESULT_OK) return false;
+    enabled_features = features;
+    pll_enabled = pll;
+    return resync();
+  }
+
   /**
    * @brief This function reads value of an audio codec register.
    *
@@ -436,11 +477,7 @@ class WM8960 {
    * wrong.
    */
   bool read(wm8960_reg_t reg, uint16_t* data) {
-    if (reg >= REGISTER_MAP_SIZE) {
-      return false;
-    }
-    *data = register_map[reg];
-    return true;
+    return regs.read(reg, data) == RESULT_OK;
   }
 
   /**
@@ -831,38 +868,38 @@ class WM8960 {
            RESULT_OK;
   }
 
-  /* Internal write with register-map cache update. */
+  /* Internal write with register-map cache update: unchanged values are not
+   * sent again */
   bool writeEx(wm8960_reg_t enum_reg, uint16_t value) {
     uint8_t reg = enum_reg;
-    uint8_t data[2];
-    data[0] = (reg << 1) | ((uint8_t)((value >> 8) & 0x0001));  // RegAddr
-    data[1] = (uint8_t)(value & 0x00FF);                        // RegValue
-    bool result = i2cWrite(i2c_addr, data);
-
-    if (result) {
-      if (reg == WM8960_REG_RESET) {
-        static const uint16_t default_register_map[REGISTER_MAP_SIZE] = {
-            0x0097, 0x0097, 0x0000, 0x0000,
-            0x0000, 0x0008, 0x0000, 0x000a,  // R0~R7
-            0x01c0, 0x0000, 0x00ff, 0x00ff,
-            0x0000, 0x0000, 0x0000, 0x0000,  // R8~R15
-            0x0000, 0x007b, 0x0100, 0x0032,
-            0x0000, 0x00c3, 0x00c3, 0x01c0,  // R16~R23
-            0x0000, 0x0000, 0x0000, 0x0000,
-            0x0000, 0x0000, 0x0000, 0x0000,  // R24~R31
-            0x0100, 0x0100, 0x0050, 0x0050,
-            0x0050, 0x0050, 0x0000, 0x0000,  // R32~R39
-            0x0000, 0x0000, 0x0040, 0x0000,
-            0x0000, 0x0050, 0x0050, 0x0000,  // R40~R47
-            0x0000, 0x0037, 0x004d, 0x0080,
-            0x0008, 0x0031, 0x0026, 0x00e9,  // R48~R55
-        };
-        memcpy(&register_map, &default_register_map, sizeof(register_map));
-      } else {
-        register_map[reg] = value;
-      }
+    if (reg == WM8960_REG_RESET) {
+      bool result = regs.writeForced(reg, value) == RESULT_OK;
+      if (result) setDefaults();
+      return result;
     }
-    return result;
+    return regs.write(reg, value) == RESULT_OK;
+  }
+
+  /// Defines the register values after a reset
+  void setDefaults() {
+    static const uint16_t default_register_map[REGISTER_MAP_SIZE] = {
+        0x0097, 0x0097, 0x0000, 0x0000,
+        0x0000, 0x0008, 0x0000, 0x000a,  // R0~R7
+        0x01c0, 0x0000, 0x00ff, 0x00ff,
+        0x0000, 0x0000, 0x0000, 0x0000,  // R8~R15
+        0x0000, 0x007b, 0x0100, 0x0032,
+        0x0000, 0x00c3, 0x00c3, 0x01c0,  // R16~R23
+        0x0000, 0x0000, 0x0000, 0x0000,
+        0x0000, 0x0000, 0x0000, 0x0000,  // R24~R31
+        0x0100, 0x0100, 0x0050, 0x0050,
+        0x0050, 0x0050, 0x0000, 0x0000,  // R32~R39
+        0x0000, 0x0000, 0x0040, 0x0000,
+        0x0000, 0x0050, 0x0050, 0x0000,  // R40~R47
+        0x0000, 0x0037, 0x004d, 0x0080,
+        0x0008, 0x0031, 0x0026, 0x00e9,  // R48~R55
+    };
+    regs.set(0, default_register_map, REGISTER_MAP_SIZE);
+    regs.setPowerOnDefaults(default_register_map);
   }
 
   bool configDefault(uint8_t features) {
@@ -1118,6 +1155,8 @@ class WM8960 {
 
     data &= ~volume_bits_mask;
     data |= (volume | update_bit);
+    // the update bit latches both channels: so this must always be sent
+    regs.invalidate(right_vol_reg);
     result = write(right_vol_reg, data);
     return result;
   }
@@ -1133,7 +1172,25 @@ class WM8960 {
    * so we store a cached copy with default of the register map in the driver
    * and is updated on every write.
    */
-  uint16_t register_map[REGISTER_MAP_SIZE] = {0};
+  struct RegInfo {
+    static uint8_t flags(size_t reg) {
+      static constexpr RegDesc reg_desc[] = {
+          {WM8960_REG_RESET, REG_VOLATILE | REG_WRITE_ONLY},
+      };
+      static_assert(reg_desc_valid(reg_desc, REGISTER_MAP_SIZE),
+                    "WM8960 reg_desc");
+      return reg_desc_flags(reg_desc, reg);
+    }
+  };
+  RegMap<uint8_t, uint16_t, REGISTER_MAP_SIZE, RegInfo> regs{this, busWrite};
+
+  static error_t busWrite(void* ref, uint8_t reg, uint16_t value) {
+    WM8960* self = (WM8960*)ref;
+    uint8_t data[2];
+    data[0] = (reg << 1) | ((uint8_t)((value >> 8) & 0x0001));  // RegAddr
+    data[1] = (uint8_t)(value & 0x00FF);                        // RegValue
+    return self->i2cWrite(self->i2c_addr, data) ? RESULT_OK : RESULT_FAIL;
+  }
 };
 
 }  // namespace audio_driver
@@ -570,21 +570,21 @@ class WM8962 : public ZephyrDriverCommon {
    * (up to the documented timeout) until it has completed.
    */
   bool runSequence(WM8962Sequence id) {
-    uint32_t delay_remaining_ms;
+    uint32_t timeout_ms;
     switch (id) {
       case WM8962Sequence::DACToHeadphonePowerUp:
-        delay_remaining_ms = 93;
+        timeout_ms = 93;
         break;
       case WM8962Sequence::AnalogueInputPowerUp:
-        delay_remaining_ms = 75;
+        timeout_ms = 75;
         break;
       case WM8962Sequence::ChipPowerDown:
-        delay_remaining_ms = 32;
+        timeout_ms = 32;
         break;
       case WM8962Sequence::SpeakerSleep:
       case WM8962Sequence::SpeakerWake:
       default:
-        delay_remaining_ms = 2;
+        timeout_ms = 2;
         break;
     }
 
@@ -592,14 +592,15 @@ class WM8962 : public ZephyrDriverCommon {
     rc &= writeRegWide(REG_WRITE_SEQ_CTRL_1, WSEQ_ENA);
     rc &= writeRegWide(REG_WRITE_SEQ_CTRL_2, (uint16_t)id);
 
-    uint16_t status = 1;
-    while (delay_remaining_ms > 0) {
-      if (!readRegWide(REG_WRITE_SEQ_CTRL_3, status)) break;
-      if ((status & 1U) == 0U) break;
-      delayMs(1);
-      delay_remaining_ms--;
-    }
-    return rc && (status & 1U) == 0U;
+    // WSEQ_BUSY
+    bool done = wait_until(
+        [&]() {
+          uint16_t status = 1;
+          return readRegWide(REG_WRITE_SEQ_CTRL_3, status) &&
+                 (status & 1U) == 0U;
+        },
+        timeout_ms);
+    return rc && done;
   }
 
  protected:
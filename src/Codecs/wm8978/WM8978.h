@@ -3,23 +3,16 @@
 #include <stdio.h>
 #include "DriverCommon.h"
 #include "Platforms/API_I2C.h"
+#include "Platforms/RegMap.h"
 
 
 namespace audio_driver {
 
-// WM8978 register value buffer zone (total 58 registers 0 to 57), occupies 116
-// bytes of memory. Because the IIC WM8978 operation does not support read
-// operations, all register values are saved locally. Write WM8978 register,
-// synchronized to the local register values; register read returns locally
-// stored value. Note: WM8978 register value is 9 bits, so use uint16_t.
-static uint16_t REGVAL_TBL[58] = {
-    0X0000, 0X0000, 0X0000, 0X0000, 0X0050, 0X0000, 0X0140, 0X0000, 0X0000,
-    0X0000, 0X0000, 0X00FF, 0X00FF, 0X0000, 0X0100, 0X00FF, 0X00FF, 0X0000,
-    0X012C, 0X002C, 0X002C, 0X002C, 0X002C, 0X0000, 0X0032, 0X0000, 0X0000,
-    0X0000, 0X0000, 0X0000, 0X0000, 0X0000, 0X0038, 0X000B, 0X0032, 0X0000,
-    0X0008, 0X000C, 0X0093, 0X00E9, 0X0000, 0X0000, 0X0000, 0X0000, 0X0003,
-    0X0010, 0X0010, 0X0100, 0X0100, 0X0002, 0X0001, 0X0001, 0X0039, 0X0039,
-    0X0039, 0X0039, 0X0001, 0X0001};
+/// Number of registers (0 to 57)
+#define WM8978_REG_COUNT 58
+/// Max number of registers which differ from the defaults: the driver
+/// writes 28 different registers
+#define WM8978_MAX_CHANGED_REGS 32
 
 class WM8978 {
  public:
@@ -71,12 +64,43 @@ class WM8978 {
   }
 
  private:
+  // WM8978 register defaults (total 58 registers 0 to 57). Because the IIC
+  // WM8978 operation does not support read operations, the register values
+  // are shadowed locally: we only keep the registers which differ from these
+  // defaults. Note: WM8978 register value is 9 bits, so use uint16_t.
+  struct RegDefaults {
+    static uint16_t get(size_t reg) {
+      static constexpr uint16_t reg_defaults[WM8978_REG_COUNT] = {
+          0X0000, 0X0000, 0X0000, 0X0000, 0X0050, 0X0000, 0X0140, 0X0000,
+          0X0000, 0X0000, 0X0000, 0X00FF, 0X00FF, 0X0000, 0X0100, 0X00FF,
+          0X00FF, 0X0000, 0X012C, 0X002C, 0X002C, 0X002C, 0X002C, 0X0000,
+          0X0032, 0X0000, 0X0000, 0X0000, 0X0000, 0X0000, 0X0000, 0X0000,
+          0X0038, 0X000B, 0X0032, 0X0000, 0X0008, 0X000C, 0X0093, 0X00E9,
+          0X0000, 0X0000, 0X0000, 0X0000, 0X0003, 0X0010, 0X0010, 0X0100,
+          0X0100, 0X0002, 0X0001, 0X0001, 0X0039, 0X0039, 0X0039, 0X0039,
+          0X0001, 0X0001};
+      return reg_defaults[reg];
+    }
+  };
   i2c_bus_handle_t p_wire = nullptr;
   int address = WM8978_ADDR;
+  SparseRegMap<uint8_t, uint16_t, WM8978_REG_COUNT, WM8978_MAX_CHANGED_REGS,
+               RegDefaults>
+      regs{this, busWrite};
   bool begin(); /* use this function if you want to setup i2c before */
   uint8_t Init(void);
   uint8_t Write_Reg(uint8_t reg, uint16_t val);
   uint16_t Read_Reg(uint8_t reg);
+
+  /// 7 bit register address + 9 bit value
+  static error_t busWrite(void* ref, uint8_t reg, uint16_t value) {
+    WM8978* self = (WM8978*)ref;
+    uint8_t data[2];
+    data[0] = (reg << 1) | ((uint8_t)((value >> 8) & 0x0001));
+    data[1] = (uint8_t)(value & 0x00FF);
+    return i2c_bus_write_bytes(self->p_wire, self->address, data, 1, data + 1,
+                               1);
+  }
 };
 
 // WM8978 write register
@@ -84,10 +108,14 @@ class WM8978 {
 // val: the value to be written to the register
 // Return value: 0, success; Other, error code
 inline uint8_t WM8978::Write_Reg(uint8_t reg, uint16_t val) {
-  uint8_t byte_val = val;
-  i2c_bus_write_bytes(p_wire, address, &reg, 1, &byte_val, 1);
-  REGVAL_TBL[reg] = val;  // Save register value to local
-  return 0;
+  if (reg == 0) {
+    // software reset: all registers are back at their defaults
+    error_t rc = regs.writeForced(reg, val);
+    regs.reset();
+    return rc == RESULT_OK ? 0 : 1;
+  }
+  // unchanged values are not written again
+  return regs.write(reg, val) == RESULT_OK ? 0 : 1;
 }
 
 // WM8978 init
@@ -119,10 +147,10 @@ inline uint8_t WM8978::Init(void) {
 }
 
 // WM8978 read register
-// Reads the value of the local register buffer zone
+// Reads the value of the local register shadow
 // reg: Register Address
 // Return Value: Register value
-inline uint16_t WM8978::Read_Reg(uint8_t reg) { return REGVAL_TBL[reg]; }
+inline uint16_t WM8978::Read_Reg(uint8_t reg) { return regs.read(reg); }
 
 // WM8978 DAC/ADC configuration
 // adcen: adc enable(1)/disable(0)
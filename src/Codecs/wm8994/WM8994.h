@@ -91,6 +91,8 @@ class WM8994 {
   static constexpr uint32_t WM8994_ID = 0x8994;
   static constexpr uint16_t WM8994_CHIPID_ADDR = 0x00;
   static constexpr int WM8994_ADDR = 0x1A;
+  /// Upper limit for the DC servo start-up (was a fixed delay)
+  static constexpr uint32_t DC_SERVO_TIMEOUT_MS = 250;
 
   WM8994() = default;
 
@@ -378,8 +380,11 @@ class WM8994 {
       /* Enable DC Servo and trigger start-up mode on left and right channels */
       counter += writeReg16(0x54, 0x0033);
 
-      /* Add Delay */
-      delayMs(250);
+      /* Wait until the DC Servo start-up triggers are cleared */
+      if (!wait_until([&]() { return (readReg16(0x54) & 0x0030) == 0; },
+                      DC_SERVO_TIMEOUT_MS)) {
+        AD_LOGW("wm8994: DC servo start-up timeout");
+      }
 
       /* Enable HPOUT1 (Left) and HPOUT1 (Right) intermediate and output stages. Remove clamps */
       counter += writeReg16(0x60, 0x00EE);
@@ -13,6 +13,13 @@
 #endif
 
 
+// Use the deferred mode of the register cache in setConfig(): registers that
+// are written multiple times are sent only once, in address order. Only
+// supported by some drivers (ES7210, ES8311, ES8388).
+#ifndef DRIVER_DEFERRED_CONFIG
+#  define DRIVER_DEFERRED_CONFIG false
+#endif
+
 // To increase the max volume e.g. for ai_thinker (ES8388) 2957 or A202 -> set
 // to 0, 1 or 2. 0: AUX volume is LINE level; 1: you can control the AUX volume with
 // setVolume()
@@ -39,6 +46,75 @@
 #  define FORCE_WIRE_CLOSE false
 #endif
 
+/// Max number of I2C buses that can be open at the same time (IDF master
+/// buses and bus locks)
+#ifndef I2C_MAX_BUSES
+#  define I2C_MAX_BUSES 2
+#endif
+
+/// Max number of I2C devices (bus/address pairs) for which we keep an open
+/// IDF device handle or the selected register page (I2CPagedRegs.h) and
+/// max number of devices per bus that are checked by i2c_bus_tune_clock()
+#ifndef I2C_MAX_DEVICES
+#  define I2C_MAX_DEVICES 8
+#endif
+
+/// Max number of data bytes that are combined into one I2C write burst: the
+/// register address and the data must fit into the 32 byte Wire buffer
+#ifndef I2C_MAX_BURST
+#  define I2C_MAX_BURST 31
+#endif
+
+/// Max number of segments of an i2c_bus_writev() call (IDF, Zephyr)
+#ifndef I2C_MAX_SEGMENTS
+#  define I2C_MAX_SEGMENTS 4
+#endif
+
+/// Number of retries of a failed I2C transfer (see I2CErrorPolicy)
+#ifndef I2C_RETRY_COUNT
+#  define I2C_RETRY_COUNT 2
+#endif
+
+/// Delay in ms before the first retry: it is doubled for each further retry
+#ifndef I2C_RETRY_BACKOFF_MS
+#  define I2C_RETRY_BACKOFF_MS 1
+#endif
+
+/// Upper limit of the retry delay in ms
+#ifndef I2C_RETRY_MAX_BACKOFF_MS
+#  define I2C_RETRY_MAX_BACKOFF_MS 16
+#endif
+
+/// IDF: timeout in ms of an I2C transfer, so that a stuck bus can be detected
+#ifndef I2C_TIMEOUT_MS
+#  define I2C_TIMEOUT_MS 50
+#endif
+
+/// Highest I2C clock that is tried by the auto_clock of InfoI2C
+#ifndef I2C_AUTO_CLOCK_MAX
+#  define I2C_AUTO_CLOCK_MAX 1000000
+#endif
+
+/// Number of reads of the verify register that must pass for a clock
+#ifndef I2C_AUTO_CLOCK_VERIFY_COUNT
+#  define I2C_AUTO_CLOCK_VERIFY_COUNT 16
+#endif
+
+/// Provide the I2CCommandQueue and the ...Async() methods of the AudioDriver:
+/// this needs <atomic>
+#ifndef AUDIO_DRIVER_ASYNC_I2C
+#  if defined(__AVR__) || defined(ESP8266)
+#    define AUDIO_DRIVER_ASYNC_I2C false
+#  else
+#    define AUDIO_DRIVER_ASYNC_I2C true
+#  endif
+#endif
+
+/// Max number of queued commands in the I2CCommandQueue (power of 2)
+#ifndef I2C_QUEUE_SIZE
+#  define I2C_QUEUE_SIZE 16
+#endif
+
 /// Activate / Deactivate Logging: set to true or false
 #ifndef AUDIO_DRIVER_LOGGIN_ACTVIE 
 #  define AUDIO_DRIVER_LOGGIN_ACTVIE true
@@ -4,18 +4,70 @@
 #  include "Arduino.h"
 namespace audio_driver {
 inline void delayMs(unsigned long ms) { delay(ms); }
+inline uint32_t uptimeMs() { return millis(); }
 } // namespace audio_driver
 #elif defined(__zephyr__)
 #  include <zephyr/kernel.h>
 namespace audio_driver {
 inline void delayMs(unsigned long ms) { k_msleep(ms); }
+inline uint32_t uptimeMs() { return (uint32_t)k_uptime_get(); }
 } // namespace audio_driver
 #elif defined(ESP32)
 namespace audio_driver {
-inline void delayMs(unsigned long ms) { vTaskDelay(ms / portTICK_PERIOD_MS); }
+// rounded up to full ticks: a delay is never shorter than requested
+inline void delayMs(unsigned long ms) {
+  vTaskDelay((ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+}
+inline uint32_t uptimeMs() {
+  return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
 } // namespace audio_driver
 #else
+#  include <chrono>
+#  include <thread>
 namespace audio_driver {
-inline void delayMs(unsigned long ms) {}
+inline void delayMs(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+inline uint32_t uptimeMs() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
 } // namespace audio_driver
 #endif
+
+namespace audio_driver {
+
+/// Result of a step function: the step function returns the delay in ms
+/// before the next step, STEP_DONE or STEP_FAILED
+static constexpr int STEP_DONE = -1;
+static constexpr int STEP_FAILED = -2;
+
+/// Executes a step function (int step(int no)) until it is done: the delays
+/// between the steps are blocking
+template <class StepFunction>
+inline bool run_steps(StepFunction step) {
+  for (int no = 0;; no++) {
+    int rc = step(no);
+    if (rc == STEP_DONE) return true;
+    if (rc < 0) return false;
+    if (rc > 0) delayMs(rc);
+  }
+}
+
+/// Polls the condition (bool condition()) every ms until it is true: returns
+/// false when timeout_ms have passed (measured with uptimeMs()). Used instead
+/// of a fixed worst case delay when the chip reports its status (e.g. PLL
+/// lock, reset or sequencer done).
+template <class Condition>
+inline bool wait_until(Condition condition, uint32_t timeout_ms) {
+  uint32_t start = uptimeMs();
+  while (true) {
+    if (condition()) return true;
+    if (uptimeMs() - start > timeout_ms) return false;
+    delayMs(1);
+  }
+}
+
+} // namespace audio_driver
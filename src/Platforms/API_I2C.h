@@ -14,12 +14,74 @@
 #elif defined(__zephyr__)
 #  include <assert.h>
 #  include <string.h>
+#  include <errno.h>
 #  include <zephyr/drivers/i2c.h>
 #  include <zephyr/kernel.h>
+#elif defined(__linux__)
+#  include <assert.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <linux/i2c-dev.h>
+#  include <linux/i2c.h>
+#  include <stdio.h>
+#  include <string.h>
+#  include <sys/ioctl.h>
+#  include <unistd.h>
+#endif
+
+// Bus lock: priority inheriting RTOS mutex or std::recursive_mutex
+#if defined(ESP32)
+#  include "freertos/FreeRTOS.h"
+#  include "freertos/semphr.h"
+#  include "freertos/task.h"
+#elif !defined(ARDUINO) && !defined(__zephyr__)
+#  include <mutex>
 #endif
+#include "Platforms/API_Delay.h"
 
 namespace audio_driver {
 
+/**
+ * @brief Defines how failed I2C transfers are handled: transient errors
+ * (NACK, arbitration lost, timeout) are retried with an exponential backoff
+ * and a stuck bus is cleared by clocking out SCL.
+ */
+struct I2CErrorPolicy {
+  /// number of retries after the first failed attempt (0 = no retry)
+  uint8_t max_retries = I2C_RETRY_COUNT;
+  /// delay before the first retry: it is doubled for each further retry
+  uint16_t backoff_ms = I2C_RETRY_BACKOFF_MS;
+  /// upper limit for the backoff delay
+  uint16_t max_backoff_ms = I2C_RETRY_MAX_BACKOFF_MS;
+  /// clear the bus (9 SCL clocks + STOP) on timeouts or a stuck bus
+  bool bus_clear = true;
+  /// probe the device address after a bus clear
+  bool reprobe = true;
+};
+
+/// Error counters of a bus: see i2c_bus_error_stats()
+struct I2CErrorStats {
+  uint32_t errors = 0;
+  uint32_t nacks = 0;
+  uint32_t arbitration_lost = 0;
+  uint32_t timeouts = 0;
+  uint32_t retries = 0;
+  uint32_t recovered = 0;
+  uint32_t failed = 0;
+  uint32_t bus_clears = 0;
+  uint32_t probe_failures = 0;
+};
+
+/// Classification of the platform specific I2C error codes
+enum class I2CErrorClass {
+  None,
+  Nack,
+  ArbitrationLost,
+  Timeout,
+  BusStuck,
+  Invalid,
+};
+
 struct I2CConfig {
   i2c_bus_handle_t p_wire;
   uint32_t frequency;
@@ -30,12 +92,177 @@ struct I2CConfig {
   GpioPin scl;
   GpioPin sda;
 #endif
+  I2CErrorPolicy error_policy;
+  /// opt-in: determine the fastest reliable clock in InfoI2C::begin()
+  bool auto_clock = false;
+  /// register (e.g. chip id) which is read to verify a clock (auto_clock)
+  int verify_reg = -1;
 };
 
 #ifndef ARDUINO
 struct TwoWire {};
 #endif
 
+/// Single register write used by i2c_bus_write_batch()
+struct RegWrite {
+  uint16_t reg;
+  uint16_t value;
+};
+
+/// Segment of a scatter-gather write: see i2c_bus_writev()
+struct I2CIoVec {
+  const void *data;
+  size_t len;
+};
+
+/// Encodes the register and value of a RegWrite MSB first with the indicated
+/// lengths (1 or 2 bytes each) and returns the number of bytes
+static inline int i2c_encode_reg_write(const RegWrite &entry, int reglen,
+                                       int datalen, uint8_t *out) {
+  int len = 0;
+  if (reglen > 1) out[len++] = entry.reg >> 8;
+  out[len++] = entry.reg & 0xFF;
+  if (datalen > 1) out[len++] = entry.value >> 8;
+  out[len++] = entry.value & 0xFF;
+  return len;
+}
+
+/**
+ * @brief Recursive mutex which serializes the access to an I2C bus. On
+ * FreeRTOS and Zephyr the mutex supports priority inheritance; on the desktop
+ * we use std::recursive_mutex and on Arduino w/o RTOS this is a no-op.
+ */
+class I2CMutex {
+ public:
+#if defined(ESP32)
+  I2CMutex() { handle = xSemaphoreCreateRecursiveMutex(); }
+  void lock() { xSemaphoreTakeRecursive(handle, portMAX_DELAY); }
+  void unlock() { xSemaphoreGiveRecursive(handle); }
+
+ protected:
+  SemaphoreHandle_t handle = nullptr;
+#elif defined(__zephyr__)
+  I2CMutex() { k_mutex_init(&mtx); }
+  void lock() { k_mutex_lock(&mtx, K_FOREVER); }
+  void unlock() { k_mutex_unlock(&mtx); }
+
+ protected:
+  struct k_mutex mtx;
+#elif !defined(ARDUINO)
+  void lock() { mtx.lock(); }
+  void unlock() { mtx.unlock(); }
+
+ protected:
+  std::recursive_mutex mtx;
+#else
+  void lock() {}
+  void unlock() {}
+#endif
+};
+
+/// Device registered by InfoI2C::begin(): all devices of a bus must pass the
+/// verification of a clock
+struct I2CBusDevice {
+  int address = 0;
+  int verify_reg = -1;
+  uint8_t expected = 0;
+};
+
+/// Lock, error policy and error counters of a bus
+struct I2CBusState {
+  i2c_bus_handle_t bus = nullptr;
+  I2CMutex mutex;
+  /// config used for the bus clear (pins, frequency) and the error policy
+  I2CConfig config{};
+  I2CErrorStats stats;
+  /// devices of the bus which were registered with i2c_bus_add_device()
+  I2CBusDevice devices[I2C_MAX_DEVICES];
+  int device_count = 0;
+  /// the clock was set by i2c_bus_tune_clock()
+  bool clock_tuned = false;
+};
+
+/// States of the buses and the lock of the table
+struct I2CBusStateTable {
+  I2CBusState entries[I2C_MAX_BUSES];
+  I2CMutex mutex;
+};
+
+/// Provides the table of the bus states (function local static: C++11 has no
+/// inline variables)
+inline I2CBusStateTable &i2c_bus_state_table() {
+  static I2CBusStateTable table;
+  return table;
+}
+
+/// Provides the state of the bus: a free entry is assigned on the first use
+static inline I2CBusState *i2c_bus_state(i2c_bus_handle_t bus) {
+  I2CBusState *result = nullptr;
+  I2CBusState *free_entry = nullptr;
+  I2CBusStateTable &table = i2c_bus_state_table();
+  table.mutex.lock();
+  for (auto &entry : table.entries) {
+    if (entry.bus == bus) {
+      result = &entry;
+      break;
+    }
+    if (free_entry == nullptr && entry.bus == nullptr) free_entry = &entry;
+  }
+  if (result == nullptr && free_entry != nullptr) {
+    free_entry->bus = bus;
+    free_entry->config.p_wire = bus;
+#if !defined(__zephyr__)
+    free_entry->config.scl = -1;
+    free_entry->config.sda = -1;
+#endif
+    result = free_entry;
+  }
+  table.mutex.unlock();
+  return result;
+}
+
+/// Provides the mutex of the bus
+static inline I2CMutex *i2c_bus_mutex(i2c_bus_handle_t bus) {
+  I2CBusState *state = i2c_bus_state(bus);
+  return state == nullptr ? nullptr : &state->mutex;
+}
+
+/// Frees the state of a deleted bus: a new bus with the same handle starts
+/// with the default clock, error policy and counters
+static inline void i2c_bus_state_release(i2c_bus_handle_t bus) {
+  I2CBusStateTable &table = i2c_bus_state_table();
+  table.mutex.lock();
+  for (auto &entry : table.entries) {
+    if (entry.bus != bus) continue;
+    entry.bus = nullptr;
+    entry.config = I2CConfig{};
+    entry.stats = I2CErrorStats{};
+    entry.device_count = 0;
+    entry.clock_tuned = false;
+  }
+  table.mutex.unlock();
+}
+
+/**
+ * @brief Transaction group: the bus is locked for the lifetime of this object,
+ * so that e.g. a read-modify-write can not be interrupted by other tasks. The
+ * lock is recursive, so the i2c_bus_* functions can be called.
+ */
+class I2CTransaction {
+ public:
+  I2CTransaction(i2c_bus_handle_t bus) : p_mutex(i2c_bus_mutex(bus)) {
+    if (p_mutex != nullptr) p_mutex->lock();
+  }
+  ~I2CTransaction() {
+    if (p_mutex != nullptr) p_mutex->unlock();
+  }
+  I2CTransaction(const I2CTransaction &) = delete;
+  I2CTransaction &operator=(const I2CTransaction &) = delete;
+
+ protected:
+  I2CMutex *p_mutex = nullptr;
+};
+
 // ---- Arduino I2C implementation ----
 #if defined(ARDUINO) && !AUDIO_DRIVER_FORCE_IDF
 
@@ -76,75 +303,248 @@ inline void i2c_bus_delete(i2c_bus_handle_t bus) {
 #if !defined(ESP8266) && FORCE_WIRE_CLOSE
   p_wire->end();
 #endif
+  i2c_bus_state_release(bus);
 }
 
-inline error_t i2c_bus_write_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
-                                   int reglen, uint8_t *data, int datalen) {
-  AD_LOGD("i2c_bus_write_bytes: addr=0x%X reglen=%d datalen=%d - reg=0x%0X ",
-          addr, reglen, datalen, reg[0]);
+/// endTransmission(): 1 data too long, 2 NACK on address, 3 NACK on data,
+/// 4 other error, 5 timeout
+static inline I2CErrorClass i2c_classify_error(int rc) {
+  switch (rc) {
+    case 0:
+      return I2CErrorClass::None;
+    case 1:
+      return I2CErrorClass::Invalid;
+    case 2:
+    case 3:
+      return I2CErrorClass::Nack;
+    case 5:
+      return I2CErrorClass::Timeout;
+    default:
+      return I2CErrorClass::BusStuck;
+  }
+}
+
+/// Wire drops the bytes which do not fit into its buffer w/o an error from
+/// endTransmission(), so a short write() is reported as data too long (1)
+static inline int i2c_raw_writev(i2c_bus_handle_t bus, int addr,
+                                 const I2CIoVec *iov, int n) {
   TwoWire *p_wire = (TwoWire *)bus;
   assert(p_wire != nullptr);
-  int result = RESULT_OK;
+  I2CTransaction lock(bus);
+  bool complete = true;
   p_wire->beginTransmission(addr);
-  if (reglen > 0) p_wire->write(reg, reglen);
-  if (datalen > 0) p_wire->write(data, datalen);
+  for (int j = 0; j < n; j++) {
+    if (iov[j].len == 0) continue;
+    size_t written = p_wire->write((const uint8_t *)iov[j].data, iov[j].len);
+    if (written != iov[j].len) complete = false;
+  }
+  // the transmission is always ended: e.g. the ESP32 releases the bus lock
   int rc = p_wire->endTransmission(I2C_END);
-  if (rc != 0) {
-    AD_LOGE("->p_wire->endTransmission: %d", rc);
-    result = RESULT_FAIL;
+  if (!complete) {
+    AD_LOGE("i2c_raw_writev: Wire buffer too small");
+    return 1;
   }
-  return result;
+  return rc;
 }
 
-inline error_t i2c_bus_read_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
-                                  int reglen, uint8_t *outdata, int datalen) {
-  AD_LOGD("i2c_bus_read_bytes: addr=0x%X reglen=%d datalen=%d - reg=0x%X", addr,
-          reglen, datalen, reg[0]);
+static inline int i2c_raw_read(i2c_bus_handle_t bus, int addr, uint8_t *reg,
+                               int reglen, uint8_t *outdata, int datalen) {
   TwoWire *p_wire = (TwoWire *)bus;
   assert(p_wire != nullptr);
-
   memset(outdata, 0, datalen);
-  int result = RESULT_OK;
-
+  I2CTransaction lock(bus);
   p_wire->beginTransmission(addr);
   p_wire->write(reg, reglen);
-  int rc = p_wire->endTransmission();
-  if (rc != 0) {
-    AD_LOGE("->p_wire->endTransmission: %d", rc);
+  // no STOP: the data is read with a repeated start
+  int rc = p_wire->endTransmission(false);
+  uint8_t result_len = p_wire->requestFrom(addr, datalen, (int)I2C_END);
+  if (result_len > 0) result_len = p_wire->readBytes(outdata, datalen);
+  if (result_len > 0) return 0;
+  AD_LOGD("->p_wire->requestFrom %d->%d", datalen, result_len);
+  return rc != 0 ? rc : 2;
+}
+
+/// Wire does not support queued transfers, so we just avoid the per register
+/// call overhead: done provides the number of written registers
+static inline int i2c_raw_write_batch(i2c_bus_handle_t bus, int addr,
+                                      const RegWrite *list, int n, int reglen,
+                                      int datalen, int *done) {
+  TwoWire *p_wire = (TwoWire *)bus;
+  assert(p_wire != nullptr);
+  uint8_t buffer[4];
+  I2CTransaction lock(bus);
+  for (int j = 0; j < n; j++) {
+    int len = i2c_encode_reg_write(list[j], reglen, datalen, buffer);
+    p_wire->beginTransmission(addr);
+    p_wire->write(buffer, len);
+    int rc = p_wire->endTransmission(I2C_END);
+    if (rc != 0) return rc;
+    (*done)++;
   }
+  return 0;
+}
 
-  uint8_t result_len = p_wire->requestFrom(addr, datalen, (int)I2C_END);
-  if (result_len > 0) {
-    result_len = p_wire->readBytes(outdata, datalen);
-  } else {
-    AD_LOGE("->p_wire->requestFrom %d->%d", datalen, result_len);
-    result = RESULT_FAIL;
+static inline int i2c_raw_probe(i2c_bus_handle_t bus, int addr) {
+  TwoWire *p_wire = (TwoWire *)bus;
+  I2CTransaction lock(bus);
+  p_wire->beginTransmission(addr);
+  return p_wire->endTransmission(I2C_END);
+}
+
+static inline bool i2c_raw_set_clock(i2c_bus_handle_t bus, uint32_t frequency) {
+  ((TwoWire *)bus)->setClock(frequency);
+  return true;
+}
+
+/// Bus clear: we release Wire and clock out SCL until the device releases
+/// SDA, send a STOP and set up Wire again. This needs the pins.
+static inline bool i2c_raw_recover(i2c_bus_handle_t bus, I2CBusState &state) {
+  I2CConfig &pins = state.config;
+  if (pins.scl == -1 || pins.sda == -1) return false;
+#if !defined(ESP8266)
+  ((TwoWire *)bus)->end();
+#endif
+  pinMode(pins.sda, INPUT_PULLUP);
+  pinMode(pins.scl, OUTPUT);
+  for (int j = 0; j < 9 && digitalRead(pins.sda) == LOW; j++) {
+    digitalWrite(pins.scl, LOW);
+    delayMicroseconds(5);
+    digitalWrite(pins.scl, HIGH);
+    delayMicroseconds(5);
   }
-  return result;
+  // STOP: SDA goes high while SCL is high
+  pinMode(pins.sda, OUTPUT);
+  digitalWrite(pins.sda, LOW);
+  delayMicroseconds(5);
+  digitalWrite(pins.scl, HIGH);
+  delayMicroseconds(5);
+  digitalWrite(pins.sda, HIGH);
+  delayMicroseconds(5);
+  pinMode(pins.sda, INPUT_PULLUP);
+  bool released = digitalRead(pins.sda) != LOW;
+  return i2c_bus_create(&pins) == RESULT_OK && released;
 }
 
 // ---- Espressif IDF I2C implementation ----
 #elif defined(ESP32_CMAKE)
 
-static I2CConfig *i2c_configs[5];
+/// Master bus created by i2c_bus_create(): shared by all users of the port
+struct I2CBusEntry {
+  i2c_master_bus_handle_t bus = nullptr;
+  int port = -1;
+  uint32_t frequency = 0;
+  int ref_count = 0;
+};
 
-static inline I2CConfig *get_config(i2c_bus_handle_t hdl) {
-  for (int j = 0; j < 5; j++) {
-    if (i2c_configs[j]->p_wire == hdl) {
-      return i2c_configs[j];
-    }
+/// Device handle which is attached once and reused for all transfers
+struct I2CDeviceEntry {
+  i2c_master_bus_handle_t bus = nullptr;
+  int address = -1;
+  i2c_master_dev_handle_t dev = nullptr;
+};
+
+/// Created buses and attached devices
+struct I2CIdfTable {
+  I2CBusEntry buses[I2C_MAX_BUSES];
+  I2CDeviceEntry devices[I2C_MAX_DEVICES];
+};
+
+/// Provides the bus and device table (function local static: C++11 has no
+/// inline variables)
+inline I2CIdfTable &i2c_idf_table() {
+  static I2CIdfTable table;
+  return table;
+}
+
+static inline I2CBusEntry *i2c_get_bus(i2c_master_bus_handle_t hdl) {
+  for (auto &entry : i2c_idf_table().buses) {
+    if (entry.bus != nullptr && entry.bus == hdl) return &entry;
   }
   return nullptr;
 }
 
+static inline I2CBusEntry *i2c_get_bus_by_port(int port) {
+  for (auto &entry : i2c_idf_table().buses) {
+    if (entry.bus != nullptr && entry.port == port) return &entry;
+  }
+  return nullptr;
+}
+
+/// Provides the cached device handle for the bus and 7 bit address: the
+/// device is added to the bus on the first access
+static inline i2c_master_dev_handle_t i2c_get_device(
+    i2c_master_bus_handle_t bus, int addr) {
+  I2CDeviceEntry *free_entry = nullptr;
+  for (auto &entry : i2c_idf_table().devices) {
+    if (entry.bus == bus && entry.address == addr) return entry.dev;
+    if (free_entry == nullptr && entry.bus == nullptr) free_entry = &entry;
+  }
+  if (free_entry == nullptr) {
+    AD_LOGE("I2C device cache full: increase I2C_MAX_DEVICES");
+    return nullptr;
+  }
+
+  I2CBusEntry *bus_entry = i2c_get_bus(bus);
+  uint32_t frequency = 100000;
+  if (bus_entry != nullptr && bus_entry->frequency > 0)
+    frequency = bus_entry->frequency;
+
+  i2c_device_config_t dev_cfg = {};
+  dev_cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+  dev_cfg.device_address = addr;
+  dev_cfg.scl_speed_hz = frequency;
+
+  i2c_master_dev_handle_t dev_handle = nullptr;
+  if (i2c_master_bus_add_device(bus, &dev_cfg, &dev_handle) != ESP_OK) {
+    AD_LOGE("i2c_master_bus_add_device: 0x%x", addr);
+    return nullptr;
+  }
+  AD_LOGI("i2c device 0x%x added (%u Hz)", addr, (unsigned)frequency);
+  free_entry->bus = bus;
+  free_entry->address = addr;
+  free_entry->dev = dev_handle;
+  return dev_handle;
+}
+
+/// Removes all cached device handles of the bus
+static inline void i2c_remove_devices(i2c_master_bus_handle_t bus) {
+  for (auto &entry : i2c_idf_table().devices) {
+    if (entry.bus != bus) continue;
+    if (i2c_master_bus_rm_device(entry.dev) != ESP_OK) {
+      AD_LOGE("i2c_master_bus_rm_device");
+    }
+    entry = I2CDeviceEntry{};
+  }
+}
+
 inline error_t i2c_bus_create(struct I2CConfig *config) {
   I2CConfig &pins = *config;
   i2c_port_t i2c_slave_port = (i2c_port_t)pins.port;
-  i2c_configs[pins.port] = config;
 
   AD_LOGI("i2c_bus_create port: %d scl: %d, sda: %d address: 0x%x", pins.port,
           pins.scl, pins.sda, pins.address);
 
+  // the port is already in use (e.g. codec, adc and expander on one bus)
+  I2CBusEntry *bus_entry = i2c_get_bus_by_port(pins.port);
+  if (bus_entry != nullptr) {
+    AD_LOGI("i2c_bus_create: reusing bus of port %d", pins.port);
+    bus_entry->ref_count++;
+    pins.p_wire = bus_entry->bus;
+    return ESP_OK;
+  }
+
+  I2CBusEntry *free_entry = nullptr;
+  for (auto &entry : i2c_idf_table().buses) {
+    if (entry.bus == nullptr) {
+      free_entry = &entry;
+      break;
+    }
+  }
+  if (free_entry == nullptr) {
+    AD_LOGE("i2c_bus_create: increase I2C_MAX_BUSES");
+    return ESP_FAIL;
+  }
+
   i2c_master_bus_config_t i2c_mst_config = {};
   i2c_mst_config.clk_source = I2C_CLK_SRC_DEFAULT;
   i2c_mst_config.i2c_port = i2c_slave_port;
@@ -165,104 +565,153 @@ inline error_t i2c_bus_create(struct I2CConfig *config) {
       auto rc = i2c_master_probe(bus_handle, j, -1);
       AD_LOGE("- address: 0x%x -> %d", j, rc);
     }
+    i2c_del_master_bus(bus_handle);
     return ESP_FAIL;
   }
 
+  free_entry->bus = bus_handle;
+  free_entry->port = pins.port;
+  free_entry->frequency = pins.frequency;
+  free_entry->ref_count = 1;
   pins.p_wire = bus_handle;
   return ESP_OK;
 }
 
 inline void i2c_bus_delete(i2c_bus_handle_t bus) {
-  if (i2c_del_master_bus((i2c_master_bus_handle_t)bus) != ESP_OK) {
+  i2c_master_bus_handle_t bus_handle = (i2c_master_bus_handle_t)bus;
+  I2CBusEntry *bus_entry = i2c_get_bus(bus_handle);
+  if (bus_entry != nullptr && --bus_entry->ref_count > 0) return;
+
+  i2c_remove_devices(bus_handle);
+  if (bus_entry != nullptr) *bus_entry = I2CBusEntry{};
+  i2c_bus_state_release(bus);
+  if (i2c_del_master_bus(bus_handle) != ESP_OK) {
     AD_LOGI("i2c_bus_delete");
   }
 }
 
-inline error_t i2c_bus_write_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
-                                   int reglen, uint8_t *data, int datalen) {
-  AD_LOGD("i2c_bus_write_bytes address: 0x%x", addr);
-  i2c_master_bus_handle_t bus_handle = (i2c_master_bus_handle_t)bus;
-
-  I2CConfig *cfg = get_config(bus);
-  assert(cfg != nullptr);
-  assert(cfg->address == addr);
-
-  i2c_device_config_t dev_cfg = {};
-  dev_cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
-  dev_cfg.device_address = cfg->address;
-  dev_cfg.scl_speed_hz = cfg->frequency;
-
-  i2c_master_dev_handle_t dev_handle;
-  if (i2c_master_bus_add_device(bus_handle, &dev_cfg, &dev_handle) != ESP_OK) {
-    AD_LOGE("i2c_new_master_bus");
-    return ESP_FAIL;
+/// ESP_FAIL is reported for a NACK; a stuck bus results in a timeout or
+/// ESP_ERR_INVALID_STATE
+static inline I2CErrorClass i2c_classify_error(int rc) {
+  switch (rc) {
+    case ESP_OK:
+      return I2CErrorClass::None;
+    case ESP_FAIL:
+    case ESP_ERR_NOT_FOUND:
+      return I2CErrorClass::Nack;
+    case ESP_ERR_TIMEOUT:
+      return I2CErrorClass::Timeout;
+    case ESP_ERR_INVALID_STATE:
+      return I2CErrorClass::BusStuck;
+    default:
+      return I2CErrorClass::Invalid;
   }
+}
 
-  int total_len = reglen + datalen;
-  uint8_t total_data[total_len];
-  memcpy(total_data, reg, reglen);
-  memcpy(total_data + reglen, data, datalen);
-
-  esp_err_t ret = ESP_OK;
-  ret |= i2c_master_transmit(dev_handle, total_data, total_len, -1);
-  if (ret == ESP_OK) {
-    ret = i2c_master_bus_wait_all_done(bus_handle, -1);
-    if (ret != ESP_OK) AD_LOGE("i2c_master_bus_wait_all_done");
-  } else {
-    AD_LOGE("i2c_master_transmit");
+/// The segments are passed to the driver w/o copying them
+static inline int i2c_raw_writev(i2c_bus_handle_t bus, int addr,
+                                 const I2CIoVec *iov, int n) {
+  i2c_master_bus_handle_t bus_handle = (i2c_master_bus_handle_t)bus;
+  if (n > I2C_MAX_SEGMENTS) {
+    AD_LOGE("i2c_bus_writev: increase I2C_MAX_SEGMENTS");
+    return ESP_ERR_INVALID_ARG;
   }
 
-  if (i2c_master_bus_rm_device(dev_handle) != ESP_OK) {
-    AD_LOGE("i2c_master_bus_rm_device");
+  i2c_master_transmit_multi_buffer_info_t buffers[I2C_MAX_SEGMENTS];
+  int count = 0;
+  for (int j = 0; j < n; j++) {
+    if (iov[j].len == 0) continue;
+    buffers[count].write_buffer = (uint8_t *)iov[j].data;
+    buffers[count].buffer_size = iov[j].len;
+    count++;
   }
 
-  if (ret != ESP_OK) {
-    AD_LOGE("i2c_bus_write_bytes");
-  }
+  I2CTransaction lock(bus);
+  i2c_master_dev_handle_t dev_handle = i2c_get_device(bus_handle, addr);
+  if (dev_handle == nullptr) return ESP_ERR_NO_MEM;
+  esp_err_t ret = i2c_master_transmit_multi_buffer(dev_handle, buffers, count,
+                                                   I2C_TIMEOUT_MS);
+  if (ret == ESP_OK)
+    ret = i2c_master_bus_wait_all_done(bus_handle, I2C_TIMEOUT_MS);
   return ret;
 }
 
-inline error_t i2c_bus_read_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
-                                  int reglen, uint8_t *read_buffer, int read_size) {
-  AD_LOGD("i2c_bus_read_bytes address: 0x%x", addr);
+static inline int i2c_raw_read(i2c_bus_handle_t bus, int addr, uint8_t *reg,
+                               int reglen, uint8_t *read_buffer,
+                               int read_size) {
   i2c_master_bus_handle_t bus_handle = (i2c_master_bus_handle_t)bus;
+  I2CTransaction lock(bus);
+  i2c_master_dev_handle_t dev_handle = i2c_get_device(bus_handle, addr);
+  if (dev_handle == nullptr) return ESP_ERR_NO_MEM;
+  esp_err_t ret = i2c_master_transmit_receive(dev_handle, reg, reglen,
+                                              read_buffer, read_size,
+                                              I2C_TIMEOUT_MS);
+  if (ret == ESP_OK)
+    ret = i2c_master_bus_wait_all_done(bus_handle, I2C_TIMEOUT_MS);
+  return ret;
+}
 
-  I2CConfig *cfg = get_config(bus);
-  assert(cfg != nullptr);
-  assert(cfg->address == addr);
-
-  i2c_device_config_t dev_cfg = {};
-  dev_cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
-  dev_cfg.device_address = cfg->address;
-  dev_cfg.scl_speed_hz = cfg->frequency;
-
-  i2c_master_dev_handle_t dev_handle;
-  if (i2c_master_bus_add_device(bus_handle, &dev_cfg, &dev_handle) != ESP_OK) {
-    AD_LOGE("i2c_master_bus_add_device");
-    return ESP_FAIL;
+/// Writes a list of registers with a single device lookup: done provides the
+/// number of written registers
+static inline int i2c_raw_write_batch(i2c_bus_handle_t bus, int addr,
+                                      const RegWrite *list, int n, int reglen,
+                                      int datalen, int *done) {
+  i2c_master_bus_handle_t bus_handle = (i2c_master_bus_handle_t)bus;
+  uint8_t buffer[4];
+  I2CTransaction lock(bus);
+  i2c_master_dev_handle_t dev_handle = i2c_get_device(bus_handle, addr);
+  if (dev_handle == nullptr) return ESP_ERR_NO_MEM;
+  for (int j = 0; j < n; j++) {
+    int len = i2c_encode_reg_write(list[j], reglen, datalen, buffer);
+    esp_err_t ret =
+        i2c_master_transmit(dev_handle, buffer, len, I2C_TIMEOUT_MS);
+    if (ret != ESP_OK) return ret;
+    (*done)++;
   }
+  return i2c_master_bus_wait_all_done(bus_handle, I2C_TIMEOUT_MS);
+}
 
-  int write_size = reglen;
-  uint8_t write_buffer[write_size];
-  memcpy(write_buffer, reg, reglen);
+static inline int i2c_raw_probe(i2c_bus_handle_t bus, int addr) {
+  I2CTransaction lock(bus);
+  return i2c_master_probe((i2c_master_bus_handle_t)bus, addr, I2C_TIMEOUT_MS);
+}
 
-  esp_err_t ret = ESP_OK;
-  ret = i2c_master_transmit_receive(dev_handle, write_buffer, write_size,
-                                    read_buffer, read_size, -1);
-  ret = i2c_master_bus_wait_all_done(bus_handle, -1);
-  if (ret != ESP_OK) {
-    AD_LOGE("i2c_bus_read_bytes");
-  }
-  if (i2c_master_bus_rm_device(dev_handle) != ESP_OK) {
-    AD_LOGI("i2c_master_bus_rm_device");
-  }
+/// The clock is defined per device: the cached device handles are removed,
+/// so that they are added again with the new clock
+static inline bool i2c_raw_set_clock(i2c_bus_handle_t bus, uint32_t frequency) {
+  I2CBusEntry *bus_entry = i2c_get_bus((i2c_master_bus_handle_t)bus);
+  if (bus_entry == nullptr) return false;
+  I2CTransaction lock(bus);
+  i2c_remove_devices(bus_entry->bus);
+  bus_entry->frequency = frequency;
+  return true;
+}
 
-  return ret;
+/// The driver clocks out SCL and sends a STOP
+static inline bool i2c_raw_recover(i2c_bus_handle_t bus, I2CBusState &state) {
+  I2CTransaction lock(bus);
+  return i2c_master_bus_reset((i2c_master_bus_handle_t)bus) == ESP_OK;
 }
 
 // ---- Zephyr I2C implementation ----
 #elif defined(__zephyr__)
 
+/// Configures the controller with the speed that matches the frequency
+static inline int i2c_zephyr_configure(struct device *dev, uint32_t frequency) {
+  uint32_t i2c_cfg = I2C_MODE_CONTROLLER;
+
+  if (frequency <= 100000) {
+    i2c_cfg |= I2C_SPEED_SET(I2C_SPEED_STANDARD);
+  } else if (frequency <= 400000) {
+    i2c_cfg |= I2C_SPEED_SET(I2C_SPEED_FAST);
+  } else if (frequency <= 1000000) {
+    i2c_cfg |= I2C_SPEED_SET(I2C_SPEED_FAST_PLUS);
+  } else {
+    i2c_cfg |= I2C_SPEED_SET(I2C_SPEED_HIGH);
+  }
+  return i2c_configure(dev, i2c_cfg);
+}
+
 inline error_t i2c_bus_create(struct I2CConfig *config) {
   AD_LOGI("i2c_bus_create");
   assert(config != NULL);
@@ -276,19 +725,7 @@ inline error_t i2c_bus_create(struct I2CConfig *config) {
   }
 
   if (config->frequency > 0) {
-    uint32_t i2c_cfg = I2C_MODE_CONTROLLER;
-
-    if (config->frequency <= 100000) {
-      i2c_cfg |= I2C_SPEED_SET(I2C_SPEED_STANDARD);
-    } else if (config->frequency <= 400000) {
-      i2c_cfg |= I2C_SPEED_SET(I2C_SPEED_FAST);
-    } else if (config->frequency <= 1000000) {
-      i2c_cfg |= I2C_SPEED_SET(I2C_SPEED_FAST_PLUS);
-    } else {
-      i2c_cfg |= I2C_SPEED_SET(I2C_SPEED_HIGH);
-    }
-
-    int rc = i2c_configure(dev, i2c_cfg);
+    int rc = i2c_zephyr_configure(dev, config->frequency);
     if (rc != 0) {
       AD_LOGE("Failed to configure I2C: %d", rc);
       return RESULT_FAIL;
@@ -300,30 +737,46 @@ inline error_t i2c_bus_create(struct I2CConfig *config) {
 }
 
 inline void i2c_bus_delete(i2c_bus_handle_t bus) {
-  (void)bus;
+  i2c_bus_state_release(bus);
 }
 
-inline error_t i2c_bus_write_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
-                                   int reglen, uint8_t *data, int datalen) {
-  AD_LOGD("i2c_bus_write_bytes: addr=0x%X reglen=%d datalen=%d reg=0x%02X",
-          addr, reglen, datalen, reglen > 0 ? reg[0] : 0);
+/// Zephyr drivers report a NACK as -EIO
+static inline I2CErrorClass i2c_classify_error(int rc) {
+  switch (rc) {
+    case 0:
+      return I2CErrorClass::None;
+    case -EIO:
+    case -ENXIO:
+      return I2CErrorClass::Nack;
+    case -EAGAIN:
+      return I2CErrorClass::ArbitrationLost;
+    case -ETIMEDOUT:
+      return I2CErrorClass::Timeout;
+    case -EBUSY:
+      return I2CErrorClass::BusStuck;
+    default:
+      return I2CErrorClass::Invalid;
+  }
+}
 
+/// Each segment is a write message w/o restart, so the segments are sent as
+/// one transfer
+static inline int i2c_raw_writev(i2c_bus_handle_t bus, int addr,
+                                 const I2CIoVec *iov, int n) {
   struct device *dev = (struct device *)bus;
   assert(dev != NULL);
+  if (n > I2C_MAX_SEGMENTS) {
+    AD_LOGE("i2c_bus_writev: increase I2C_MAX_SEGMENTS");
+    return -EINVAL;
+  }
 
-  struct i2c_msg msgs[2];
+  struct i2c_msg msgs[I2C_MAX_SEGMENTS];
   uint8_t num_msgs = 0;
 
-  if (reglen > 0) {
-    msgs[num_msgs].buf = reg;
-    msgs[num_msgs].len = reglen;
-    msgs[num_msgs].flags = I2C_MSG_WRITE;
-    num_msgs++;
-  }
-
-  if (datalen > 0) {
-    msgs[num_msgs].buf = data;
-    msgs[num_msgs].len = datalen;
+  for (int j = 0; j < n; j++) {
+    if (iov[j].len == 0) continue;
+    msgs[num_msgs].buf = (uint8_t *)iov[j].data;
+    msgs[num_msgs].len = (uint32_t)iov[j].len;
     msgs[num_msgs].flags = I2C_MSG_WRITE;
     num_msgs++;
   }
@@ -332,19 +785,12 @@ inline error_t i2c_bus_write_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
     msgs[num_msgs - 1].flags |= I2C_MSG_STOP;
   }
 
-  int rc = i2c_transfer(dev, msgs, num_msgs, (uint16_t)addr);
-  if (rc != 0) {
-    AD_LOGE("i2c_transfer (write) failed: %d", rc);
-    return RESULT_FAIL;
-  }
-  return RESULT_OK;
+  I2CTransaction lock(bus);
+  return i2c_transfer(dev, msgs, num_msgs, (uint16_t)addr);
 }
 
-inline error_t i2c_bus_read_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
-                                  int reglen, uint8_t *outdata, int datalen) {
-  AD_LOGD("i2c_bus_read_bytes: addr=0x%X reglen=%d datalen=%d reg=0x%02X", addr,
-          reglen, datalen, reglen > 0 ? reg[0] : 0);
-
+static inline int i2c_raw_read(i2c_bus_handle_t bus, int addr, uint8_t *reg,
+                               int reglen, uint8_t *outdata, int datalen) {
   struct device *dev = (struct device *)bus;
   assert(reglen == 1);
   assert(dev != NULL);
@@ -364,14 +810,553 @@ inline error_t i2c_bus_read_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
       },
   };
 
-  int rc = i2c_transfer(dev, msgs, 2, (uint16_t)addr);
-  if (rc != 0) {
-    AD_LOGE("i2c_transfer (read) failed: %d", rc);
+  I2CTransaction lock(bus);
+  return i2c_transfer(dev, msgs, 2, (uint16_t)addr);
+}
+
+/// Each register is a separate message (with repeated start) and a chunk of
+/// messages is submitted with one i2c_transfer: done provides the number of
+/// registers of the successful chunks
+static inline int i2c_raw_write_batch(i2c_bus_handle_t bus, int addr,
+                                      const RegWrite *list, int n, int reglen,
+                                      int datalen, int *done) {
+  struct device *dev = (struct device *)bus;
+  assert(dev != NULL);
+
+  const int max_msgs = 16;
+  struct i2c_msg msgs[max_msgs];
+  uint8_t buffer[max_msgs][4];
+
+  I2CTransaction lock(bus);
+  for (int start = 0; start < n; start += max_msgs) {
+    int count = n - start < max_msgs ? n - start : max_msgs;
+    for (int j = 0; j < count; j++) {
+      msgs[j].buf = buffer[j];
+      msgs[j].len =
+          i2c_encode_reg_write(list[start + j], reglen, datalen, buffer[j]);
+      msgs[j].flags = I2C_MSG_WRITE;
+      if (j > 0) msgs[j].flags |= I2C_MSG_RESTART;
+    }
+    msgs[count - 1].flags |= I2C_MSG_STOP;
+    int rc = i2c_transfer(dev, msgs, count, (uint16_t)addr);
+    if (rc != 0) return rc;
+    *done += count;
+  }
+  return 0;
+}
+
+static inline int i2c_raw_probe(i2c_bus_handle_t bus, int addr) {
+  I2CTransaction lock(bus);
+  return i2c_write((struct device *)bus, nullptr, 0, (uint16_t)addr);
+}
+
+static inline bool i2c_raw_set_clock(i2c_bus_handle_t bus, uint32_t frequency) {
+  I2CTransaction lock(bus);
+  return i2c_zephyr_configure((struct device *)bus, frequency) == 0;
+}
+
+static inline bool i2c_raw_recover(i2c_bus_handle_t bus, I2CBusState &state) {
+  I2CTransaction lock(bus);
+  return i2c_recover_bus((struct device *)bus) == 0;
+}
+
+// ---- Linux userspace I2C implementation (/dev/i2c-N) ----
+#elif defined(__linux__)
+
+/// System calls used to access /dev/i2c-N: they can be replaced e.g. to
+/// simulate the devices in tests
+struct I2CLinuxSyscalls {
+  int (*open)(const char *path, int flags);
+  int (*close)(int fd);
+  int (*ioctl)(int fd, unsigned long request, void *arg);
+  /// optional: the clock is usually defined by the device tree of the adapter
+  int (*set_clock)(int fd, uint32_t frequency);
+};
+
+static inline int i2c_linux_open(const char *path, int flags) {
+  return ::open(path, flags);
+}
+static inline int i2c_linux_close(int fd) { return ::close(fd); }
+static inline int i2c_linux_ioctl(int fd, unsigned long request, void *arg) {
+  return ::ioctl(fd, request, arg);
+}
+
+/// Provides the system calls (function local static: C++11 has no inline
+/// variables)
+inline I2CLinuxSyscalls &i2c_linux_syscalls() {
+  static I2CLinuxSyscalls syscalls = {i2c_linux_open, i2c_linux_close,
+                                      i2c_linux_ioctl, nullptr};
+  return syscalls;
+}
+
+/// Opened i2c-dev device: shared by all users of the port
+struct I2CLinuxBus {
+  int port = -1;
+  int fd = -1;
+  int ref_count = 0;
+};
+
+/// Opened buses
+struct I2CLinuxTable {
+  I2CLinuxBus buses[I2C_MAX_BUSES];
+};
+
+/// Provides the table of the opened buses
+inline I2CLinuxTable &i2c_linux_table() {
+  static I2CLinuxTable table;
+  return table;
+}
+
+/// Submits the messages as one combined transaction (repeated start between
+/// the messages and a single stop at the end): returns 0 or -errno
+static inline int i2c_linux_transfer(i2c_bus_handle_t bus,
+                                     struct ::i2c_msg *msgs, int n) {
+  I2CLinuxBus *entry = (I2CLinuxBus *)bus;
+  assert(entry != nullptr);
+  struct ::i2c_rdwr_ioctl_data data;
+  data.msgs = msgs;
+  data.nmsgs = n;
+  I2CTransaction lock(bus);
+  int rc = i2c_linux_syscalls().ioctl(entry->fd, I2C_RDWR, &data);
+  if (rc < 0) return errno != 0 ? -errno : -EIO;
+  return 0;
+}
+
+/// The adapter drivers report a NACK as -ENXIO, -EREMOTEIO or -EIO
+static inline I2CErrorClass i2c_classify_error(int rc) {
+  switch (rc) {
+    case 0:
+      return I2CErrorClass::None;
+    case -ENXIO:
+    case -EREMOTEIO:
+    case -EIO:
+      return I2CErrorClass::Nack;
+    case -EAGAIN:
+      return I2CErrorClass::ArbitrationLost;
+    case -ETIMEDOUT:
+      return I2CErrorClass::Timeout;
+    case -EBUSY:
+      return I2CErrorClass::BusStuck;
+    default:
+      return I2CErrorClass::Invalid;
+  }
+}
+
+inline error_t i2c_bus_create(struct I2CConfig *config) {
+  assert(config != nullptr);
+  I2CConfig &pins = *config;
+  int port = pins.port < 0 ? 1 : pins.port;
+  AD_LOGI("i2c_bus_create port: %d address: 0x%x", port, pins.address);
+
+  I2CLinuxBus *free_entry = nullptr;
+  for (auto &entry : i2c_linux_table().buses) {
+    if (entry.fd >= 0 && entry.port == port) {
+      AD_LOGI("i2c_bus_create: reusing bus of port %d", port);
+      entry.ref_count++;
+      pins.p_wire = &entry;
+      return RESULT_OK;
+    }
+    if (free_entry == nullptr && entry.fd < 0) free_entry = &entry;
+  }
+  if (free_entry == nullptr) {
+    AD_LOGE("i2c_bus_create: increase I2C_MAX_BUSES");
+    return RESULT_FAIL;
+  }
+
+  char path[32];
+  snprintf(path, sizeof(path), "/dev/i2c-%d", port);
+  int fd = i2c_linux_syscalls().open(path, O_RDWR);
+  if (fd < 0) {
+    AD_LOGE("i2c_bus_create: could not open %s", path);
     return RESULT_FAIL;
   }
+  // the clock is defined by the device tree of the adapter
+  if (pins.frequency > 0) {
+    AD_LOGI("I2C clock %u is ignored: defined by the adapter",
+            (unsigned)pins.frequency);
+  }
+
+  free_entry->port = port;
+  free_entry->fd = fd;
+  free_entry->ref_count = 1;
+  pins.p_wire = free_entry;
   return RESULT_OK;
 }
 
+inline void i2c_bus_delete(i2c_bus_handle_t bus) {
+  I2CLinuxBus *entry = (I2CLinuxBus *)bus;
+  if (entry == nullptr || entry->fd < 0) return;
+  if (--entry->ref_count > 0) return;
+  i2c_linux_syscalls().close(entry->fd);
+  *entry = I2CLinuxBus{};
+  i2c_bus_state_release(bus);
+}
+
+/// A write is one message, so the kernel needs the segments in one buffer
+/// (I2C_M_NOSTART is not supported by most adapters): long bursts (e.g.
+/// TAS5805M tables) fall back to the heap
+static inline int i2c_raw_writev(i2c_bus_handle_t bus, int addr,
+                                 const I2CIoVec *iov, int n) {
+  const size_t stack_len = 4 + I2C_MAX_BURST;
+  uint8_t stack_buffer[stack_len];
+  size_t total_len = 0;
+  for (int j = 0; j < n; j++) total_len += iov[j].len;
+  uint8_t *buffer =
+      total_len > stack_len ? new uint8_t[total_len] : stack_buffer;
+  size_t pos = 0;
+  for (int j = 0; j < n; j++) {
+    if (iov[j].len > 0) memcpy(buffer + pos, iov[j].data, iov[j].len);
+    pos += iov[j].len;
+  }
+
+  struct ::i2c_msg msg;
+  msg.addr = (uint16_t)addr;
+  msg.flags = 0;
+  msg.len = (uint16_t)total_len;
+  msg.buf = buffer;
+  int rc = i2c_linux_transfer(bus, &msg, 1);
+  if (buffer != stack_buffer) delete[] buffer;
+  return rc;
+}
+
+static inline int i2c_raw_read(i2c_bus_handle_t bus, int addr, uint8_t *reg,
+                               int reglen, uint8_t *outdata, int datalen) {
+  memset(outdata, 0, datalen);
+
+  struct ::i2c_msg msgs[2];
+  msgs[0].addr = (uint16_t)addr;
+  msgs[0].flags = 0;
+  msgs[0].len = (uint16_t)reglen;
+  msgs[0].buf = reg;
+  msgs[1].addr = (uint16_t)addr;
+  msgs[1].flags = I2C_M_RD;
+  msgs[1].len = (uint16_t)datalen;
+  msgs[1].buf = outdata;
+  return i2c_linux_transfer(bus, msgs, 2);
+}
+
+/// Each register is a separate message and a chunk of messages is submitted
+/// with one ioctl (repeated start): done provides the number of registers of
+/// the successful chunks
+static inline int i2c_raw_write_batch(i2c_bus_handle_t bus, int addr,
+                                      const RegWrite *list, int n, int reglen,
+                                      int datalen, int *done) {
+  // the kernel accepts max I2C_RDWR_IOCTL_MAX_MSGS (42) messages
+  const int max_msgs = 32;
+  struct ::i2c_msg msgs[max_msgs];
+  uint8_t buffer[max_msgs][4];
+
+  I2CTransaction lock(bus);
+  for (int start = 0; start < n; start += max_msgs) {
+    int count = n - start < max_msgs ? n - start : max_msgs;
+    for (int j = 0; j < count; j++) {
+      msgs[j].addr = (uint16_t)addr;
+      msgs[j].flags = 0;
+      msgs[j].len =
+          i2c_encode_reg_write(list[start + j], reglen, datalen, buffer[j]);
+      msgs[j].buf = buffer[j];
+    }
+    int rc = i2c_linux_transfer(bus, msgs, count);
+    if (rc != 0) return rc;
+    *done += count;
+  }
+  return 0;
+}
+
+/// Zero length write: this is supported by most adapters
+static inline int i2c_raw_probe(i2c_bus_handle_t bus, int addr) {
+  struct ::i2c_msg msg;
+  msg.addr = (uint16_t)addr;
+  msg.flags = 0;
+  msg.len = 0;
+  msg.buf = nullptr;
+  return i2c_linux_transfer(bus, &msg, 1);
+}
+
+/// The clock is defined by the device tree of the adapter unless a set_clock
+/// system call has been provided
+static inline bool i2c_raw_set_clock(i2c_bus_handle_t bus, uint32_t frequency) {
+  I2CLinuxBus *entry = (I2CLinuxBus *)bus;
+  if (entry == nullptr || i2c_linux_syscalls().set_clock == nullptr)
+    return false;
+  return i2c_linux_syscalls().set_clock(entry->fd, frequency) == 0;
+}
+
+/// The bus recovery is done by the kernel adapter driver
+static inline bool i2c_raw_recover(i2c_bus_handle_t bus, I2CBusState &state) {
+  return false;
+}
+
 #endif  // platform selection
 
+static inline const char *i2c_error_class_str(I2CErrorClass cls) {
+  switch (cls) {
+    case I2CErrorClass::None:
+      return "none";
+    case I2CErrorClass::Nack:
+      return "NACK";
+    case I2CErrorClass::ArbitrationLost:
+      return "arbitration lost";
+    case I2CErrorClass::Timeout:
+      return "timeout";
+    case I2CErrorClass::BusStuck:
+      return "bus stuck";
+    default:
+      return "invalid";
+  }
+}
+
+static inline void i2c_count_error(I2CErrorStats &stats, I2CErrorClass cls) {
+  stats.errors++;
+  if (cls == I2CErrorClass::Nack) stats.nacks++;
+  if (cls == I2CErrorClass::ArbitrationLost) stats.arbitration_lost++;
+  if (cls == I2CErrorClass::Timeout) stats.timeouts++;
+}
+
+/// Executes the transfer and applies the error policy of the bus: transient
+/// errors are retried with an exponential backoff and a stuck bus is cleared.
+/// The bus stays locked, so the retry can not be interleaved by other tasks.
+template <typename Op>
+static inline error_t i2c_bus_execute(i2c_bus_handle_t bus, int addr,
+                                      const char *name, Op op) {
+  I2CTransaction lock(bus);
+  int rc = op();
+  if (rc == 0) return RESULT_OK;
+
+  I2CBusState *state = i2c_bus_state(bus);
+  I2CErrorClass cls = i2c_classify_error(rc);
+  if (state == nullptr) {
+    AD_LOGE("%s: addr=0x%X %s (%d)", name, addr, i2c_error_class_str(cls), rc);
+    return RESULT_FAIL;
+  }
+  I2CErrorStats &stats = state->stats;
+  const I2CErrorPolicy &policy = state->config.error_policy;
+  i2c_count_error(stats, cls);
+
+  uint32_t backoff_ms = policy.backoff_ms;
+  for (int retry = 1;
+       retry <= policy.max_retries && cls != I2CErrorClass::Invalid; retry++) {
+    AD_LOGI("%s: addr=0x%X %s (%d) - retry %d", name, addr,
+            i2c_error_class_str(cls), rc, retry);
+    if (policy.bus_clear && (cls == I2CErrorClass::Timeout ||
+                             cls == I2CErrorClass::BusStuck)) {
+      stats.bus_clears++;
+      if (!i2c_raw_recover(bus, *state)) {
+        AD_LOGW("%s: bus clear not possible", name);
+      } else if (policy.reprobe && i2c_raw_probe(bus, addr) != 0) {
+        AD_LOGW("%s: device 0x%X not responding", name, addr);
+        stats.probe_failures++;
+      }
+    }
+    if (backoff_ms > 0) delayMs(backoff_ms);
+    backoff_ms *= 2;
+    if (backoff_ms > policy.max_backoff_ms) backoff_ms = policy.max_backoff_ms;
+
+    stats.retries++;
+    rc = op();
+    if (rc == 0) {
+      stats.recovered++;
+      return RESULT_OK;
+    }
+    cls = i2c_classify_error(rc);
+    i2c_count_error(stats, cls);
+  }
+
+  stats.failed++;
+  AD_LOGE("%s: addr=0x%X %s (%d)", name, addr, i2c_error_class_str(cls), rc);
+  return RESULT_FAIL;
+}
+
+/// Writes the segments in one transaction: e.g. the register address followed
+/// by the data w/o copying them into one buffer
+inline error_t i2c_bus_writev(i2c_bus_handle_t bus, int addr,
+                              const I2CIoVec *iov, int n) {
+  AD_LOGD("i2c_bus_writev: addr=0x%X n=%d", addr, n);
+  return i2c_bus_execute(bus, addr, "i2c_bus_writev",
+                         [&]() { return i2c_raw_writev(bus, addr, iov, n); });
+}
+
+/// Writes the register address followed by the data in one transaction
+inline error_t i2c_bus_write_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
+                                   int reglen, uint8_t *data, int datalen) {
+  AD_LOGD("i2c_bus_write_bytes: addr=0x%X reglen=%d datalen=%d reg=0x%02X",
+          addr, reglen, datalen, reglen > 0 ? reg[0] : 0);
+  I2CIoVec iov[2] = {{reg, (size_t)reglen}, {data, (size_t)datalen}};
+  return i2c_bus_writev(bus, addr, iov, 2);
+}
+
+/// Writes the register address and reads the data with a repeated start
+inline error_t i2c_bus_read_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
+                                  int reglen, uint8_t *outdata, int datalen) {
+  AD_LOGD("i2c_bus_read_bytes: addr=0x%X reglen=%d datalen=%d reg=0x%02X", addr,
+          reglen, datalen, reglen > 0 ? reg[0] : 0);
+  return i2c_bus_execute(bus, addr, "i2c_bus_read_bytes", [&]() {
+    return i2c_raw_read(bus, addr, reg, reglen, outdata, datalen);
+  });
+}
+
+/// Reads n consecutive 8 bit registers: the register address is sent once and
+/// the data is read with a repeated start, relying on the auto increment of
+/// the chip (incr_flag is or-ed into the address, e.g. 0x80 for the CS42448).
+/// Long reads are split into chunks of I2C_MAX_BURST bytes.
+inline error_t i2c_bus_read_regs(i2c_bus_handle_t bus, int addr,
+                                 uint8_t start_reg, uint8_t *buf, int n,
+                                 uint8_t incr_flag = 0) {
+  AD_LOGD("i2c_bus_read_regs: addr=0x%X reg=0x%02X n=%d", addr, start_reg, n);
+  I2CTransaction lock(bus);
+  for (int pos = 0; pos < n; pos += I2C_MAX_BURST) {
+    int len = n - pos < I2C_MAX_BURST ? n - pos : I2C_MAX_BURST;
+    uint8_t reg = (uint8_t)(start_reg + pos);
+    if (len > 1) reg |= incr_flag;
+    if (i2c_bus_read_bytes(bus, addr, &reg, 1, buf + pos, len) != RESULT_OK)
+      return RESULT_FAIL;
+  }
+  return RESULT_OK;
+}
+
+/// Writes a list of registers with the minimum number of transfers supported
+/// by the platform: a retry continues with the first register that failed
+inline error_t i2c_bus_write_batch(i2c_bus_handle_t bus, int addr,
+                                   const RegWrite *list, int n, int reglen = 1,
+                                   int datalen = 1) {
+  AD_LOGD("i2c_bus_write_batch: addr=0x%X n=%d", addr, n);
+  int done = 0;
+  return i2c_bus_execute(bus, addr, "i2c_bus_write_batch", [&]() {
+    return i2c_raw_write_batch(bus, addr, list + done, n - done, reglen,
+                               datalen, &done);
+  });
+}
+
+/// Defines the error policy and the pins for the bus clear: called by
+/// InfoI2C::begin()
+inline void i2c_bus_set_error_policy(const I2CConfig &config) {
+  I2CBusState *state = i2c_bus_state(config.p_wire);
+  if (state == nullptr) return;
+  I2CTransaction lock(config.p_wire);
+  state->config = config;
+}
+
+/// Registers a device of the bus (called by InfoI2C::begin()): a tuned clock
+/// was not verified with the new device, so we go back to the configured
+/// frequency until the bus is tuned again
+inline error_t i2c_bus_add_device(const I2CConfig &config) {
+  I2CBusState *state = i2c_bus_state(config.p_wire);
+  if (state == nullptr) return RESULT_FAIL;
+  I2CTransaction lock(config.p_wire);
+  if (state->device_count >= I2C_MAX_DEVICES) {
+    AD_LOGE("i2c_bus_add_device: increase I2C_MAX_DEVICES");
+    return RESULT_FAIL;
+  }
+  I2CBusDevice &device = state->devices[state->device_count++];
+  device.address = config.address;
+  device.verify_reg = config.verify_reg;
+  device.expected = 0;
+  if (state->clock_tuned && config.frequency > 0) {
+    AD_LOGI("i2c_bus_add_device: 0x%X -> %u Hz", config.address,
+            (unsigned)config.frequency);
+    i2c_raw_set_clock(config.p_wire, config.frequency);
+    state->clock_tuned = false;
+  }
+  return RESULT_OK;
+}
+
+/// Removes a device that was registered with i2c_bus_add_device()
+inline void i2c_bus_remove_device(const I2CConfig &config) {
+  I2CBusState *state = i2c_bus_state(config.p_wire);
+  if (state == nullptr) return;
+  I2CTransaction lock(config.p_wire);
+  for (int j = 0; j < state->device_count; j++) {
+    if (state->devices[j].address != config.address) continue;
+    state->devices[j] = state->devices[--state->device_count];
+    return;
+  }
+}
+
+/// Reads the verify register of all devices I2C_AUTO_CLOCK_VERIFY_COUNT times
+/// w/o retries: all reads must succeed and provide the expected values
+static inline bool i2c_bus_verify_clock(i2c_bus_handle_t bus,
+                                        const I2CBusState &state) {
+  for (int d = 0; d < state.device_count; d++) {
+    const I2CBusDevice &device = state.devices[d];
+    uint8_t reg = (uint8_t)device.verify_reg;
+    for (int j = 0; j < I2C_AUTO_CLOCK_VERIFY_COUNT; j++) {
+      uint8_t value = 0;
+      if (i2c_raw_read(bus, device.address, &reg, 1, &value, 1) != 0)
+        return false;
+      if (value != device.expected) return false;
+    }
+  }
+  return true;
+}
+
+/// Steps the bus clock through 100k, 400k and 1M (up to I2C_AUTO_CLOCK_MAX)
+/// and keeps the fastest clock at which the verify_reg of every device of the
+/// bus can be read reliably. For the margin the kept clock is checked again
+/// after the next higher step: if this fails we go one step down. Buses with
+/// a device w/o verify_reg are not tuned. The result is stored in
+/// config.frequency.
+inline error_t i2c_bus_tune_clock(I2CConfig &config) {
+  const uint32_t steps[] = {100000, 400000, 1000000};
+  i2c_bus_handle_t bus = config.p_wire;
+  I2CBusState *state = i2c_bus_state(bus);
+  if (state == nullptr || state->device_count == 0) {
+    AD_LOGW("i2c_bus_tune_clock: no devices");
+    return RESULT_FAIL;
+  }
+
+  I2CTransaction lock(bus);
+  for (int d = 0; d < state->device_count; d++) {
+    if (state->devices[d].verify_reg < 0 || state->devices[d].address <= 0) {
+      AD_LOGW("i2c_bus_tune_clock: 0x%X has no verify_reg: not tuned",
+              state->devices[d].address);
+      return RESULT_FAIL;
+    }
+  }
+  if (!i2c_raw_set_clock(bus, steps[0])) {
+    AD_LOGW("i2c_bus_tune_clock: not supported");
+    return RESULT_FAIL;
+  }
+  bool ok = true;
+  for (int d = 0; d < state->device_count && ok; d++) {
+    I2CBusDevice &device = state->devices[d];
+    uint8_t reg = (uint8_t)device.verify_reg;
+    ok = i2c_raw_read(bus, device.address, &reg, 1, &device.expected, 1) == 0;
+  }
+  if (!ok || !i2c_bus_verify_clock(bus, *state)) {
+    AD_LOGE("i2c_bus_tune_clock: fails at %u Hz", (unsigned)steps[0]);
+    if (config.frequency > 0) i2c_raw_set_clock(bus, config.frequency);
+    return RESULT_FAIL;
+  }
+
+  size_t fastest = 0;
+  for (size_t j = 1; j < sizeof(steps) / sizeof(steps[0]); j++) {
+    if (steps[j] > I2C_AUTO_CLOCK_MAX) break;
+    if (!i2c_raw_set_clock(bus, steps[j])) break;
+    if (!i2c_bus_verify_clock(bus, *state)) break;
+    fastest = j;
+  }
+  i2c_raw_set_clock(bus, steps[fastest]);
+  while (fastest > 0 && !i2c_bus_verify_clock(bus, *state)) {
+    i2c_raw_set_clock(bus, steps[--fastest]);
+  }
+  uint32_t result = steps[fastest];
+  AD_LOGI("i2c_bus_tune_clock: %d devices -> %u Hz", state->device_count,
+          (unsigned)result);
+  state->clock_tuned = true;
+  config.frequency = result;
+  return RESULT_OK;
+}
+
+/// Provides the error counters of the bus
+inline I2CErrorStats i2c_bus_error_stats(i2c_bus_handle_t bus) {
+  I2CBusState *state = i2c_bus_state(bus);
+  return state == nullptr ? I2CErrorStats{} : state->stats;
+}
+
+/// Resets the error counters of the bus
+inline void i2c_bus_reset_error_stats(i2c_bus_handle_t bus) {
+  I2CBusState *state = i2c_bus_state(bus);
+  if (state != nullptr) state->stats = I2CErrorStats{};
+}
+
 } // namespace audio_driver
@@ -8,4 +8,7 @@
 #elif defined(ARDUINO)
 #  include "Platforms/GPIO_Arduino.h"
 #  include "Platforms/GPIOExt.h"
+#elif defined(__linux__)
+#  include "Platforms/GPIO_Linux.h"
+#  include "Platforms/GPIOExt.h"
 #endif
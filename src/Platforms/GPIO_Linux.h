@@ -0,0 +1,32 @@
+#pragma once
+#if defined(__linux__) && !defined(ARDUINO) && !defined(ESP32_CMAKE)
+#include "API_GPIO.h"
+
+namespace audio_driver {
+
+/**
+ * @class GPIO
+ * @brief Linux userspace: the codec related pins (reset, PA enable) are
+ * usually managed by the device tree, so the GPIO access is a no-op.
+ */
+class GPIO : public API_GPIO {
+ public:
+  GPIO() = default;
+
+  bool begin(IDriverDeviceInfo &pins) { return true; }
+
+  void end() {}
+
+  void pinMode(GpioPin pin, int mode) {}
+
+  bool digitalWrite(GpioPin pin, bool value) { return true; }
+
+  bool digitalRead(GpioPin pin) { return false; }
+
+  /// ADC is not supported
+  int analogRead(ADCPin pin) { return -1; }
+};
+
+}  // namespace audio_driver
+
+#endif
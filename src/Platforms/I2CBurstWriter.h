@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+
+#include "DriverCommon.h"
+#include "Platforms/API_I2C.h"
+
+namespace audio_driver {
+
+/**
+ * @brief Describes if and how a chip auto increments the register address
+ * during a write burst. Codecs opt in by defining a
+ * static constexpr I2CBurstTrait burstTrait() method.
+ */
+struct I2CBurstTrait {
+  constexpr I2CBurstTrait(bool auto_increment = false, uint8_t incr_flag = 0,
+                          int max_len = I2C_MAX_BURST)
+      : auto_increment(auto_increment),
+        incr_flag(incr_flag),
+        max_len(max_len) {}
+
+  /// the chip increments the register address after each data byte
+  bool auto_increment;
+  /// flag that needs to be set in the register address to activate the auto
+  /// increment (e.g. MAP INCR bit 0x80 of the CS42448)
+  uint8_t incr_flag;
+  /// max number of data bytes in one burst
+  int max_len;
+};
+
+/**
+ * @brief Write combining for 8 bit registers with 8 bit values: consecutive
+ * register addresses are collected and sent as one START/STOP burst. Chips
+ * w/o auto increment just get one transaction per register.
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class I2CBurstWriter {
+ public:
+  I2CBurstWriter(i2c_bus_handle_t bus, int addr, const I2CBurstTrait &trait)
+      : bus(bus), addr(addr), trait(trait) {
+    max_len = trait.auto_increment ? trait.max_len : 1;
+    if (max_len > I2C_MAX_BURST) max_len = I2C_MAX_BURST;
+    if (max_len < 1) max_len = 1;
+  }
+
+  ~I2CBurstWriter() { flush(); }
+
+  /// Adds a register write: the pending burst is sent if the register does
+  /// not follow the last one
+  error_t write(uint8_t reg, uint8_t value) {
+    if (len > 0 && (reg != (uint8_t)(start_reg + len) || len >= max_len))
+      flush();
+    if (len == 0) start_reg = reg;
+    buffer[len++] = value;
+    if (len >= max_len) flush();
+    return result;
+  }
+
+  /// Sends the pending burst: returns RESULT_FAIL if any transfer failed
+  error_t flush() {
+    if (len == 0) return result;
+    uint8_t reg = start_reg;
+    if (len > 1) reg |= trait.incr_flag;
+    AD_LOGD("I2CBurstWriter: reg=0x%X len=%d", start_reg, len);
+    if (i2c_bus_write_bytes(bus, addr, &reg, 1, buffer, len) != RESULT_OK) {
+      result = RESULT_FAIL;
+    }
+    len = 0;
+    return result;
+  }
+
+ protected:
+  i2c_bus_handle_t bus;
+  int addr;
+  I2CBurstTrait trait;
+  int max_len = 1;
+  uint8_t start_reg = 0;
+  uint8_t buffer[I2C_MAX_BURST];
+  int len = 0;
+  error_t result = RESULT_OK;
+};
+
+}  // namespace audio_driver
@@ -0,0 +1,322 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "DriverCommon.h"
+#include "Platforms/API_I2C.h"
+
+#if defined(ESP32)
+#  include "freertos/FreeRTOS.h"
+#  include "freertos/task.h"
+#elif !defined(ARDUINO) && !defined(__zephyr__)
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#  define I2C_QUEUE_STD_THREAD
+#endif
+#include "Platforms/API_Delay.h"
+
+namespace audio_driver {
+
+/**
+ * @brief Bounded lock free multi producer / multi consumer queue (based on
+ * the algorithm by Dmitry Vyukov). N must be a power of 2.
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+template <typename T, size_t N>
+class LockFreeQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of 2");
+
+ public:
+  LockFreeQueue() {
+    for (size_t j = 0; j < N; j++) cells[j].seq.store(j);
+  }
+
+  /// Adds an entry: returns false if the queue is full
+  bool push(const T &value) {
+    Cell *cell;
+    size_t pos = tail.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells[pos & (N - 1)];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (tail.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = value;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Removes the oldest entry: returns false if the queue is empty
+  bool pop(T &value) {
+    Cell *cell;
+    size_t pos = head.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells[pos & (N - 1)];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (head.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head.load(std::memory_order_relaxed);
+      }
+    }
+    value = cell->data;
+    cell->seq.store(pos + N, std::memory_order_release);
+    return true;
+  }
+
+  /// Returns true if there are no entries
+  bool isEmpty() const {
+    return head.load(std::memory_order_acquire) ==
+           tail.load(std::memory_order_acquire);
+  }
+
+ protected:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T data;
+  };
+  Cell cells[N];
+  std::atomic<size_t> head{0};
+  std::atomic<size_t> tail{0};
+};
+
+/**
+ * @brief Completion handle of a queued I2C command: it can be polled or
+ * you can register a callback that is executed by the worker.
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class I2CCompletion {
+ public:
+  enum State { Idle, Pending, Done };
+
+  I2CCompletion() = default;
+  I2CCompletion(void (*callback)(error_t result, void *ref), void *ref)
+      : callback(callback), ref(ref) {}
+
+  /// Returns true when the command has been executed
+  bool isDone() const { return state.load() == Done; }
+
+  /// Returns true while the command is waiting in the queue
+  bool isPending() const { return state.load() == Pending; }
+
+  /// Provides the result of the executed command
+  error_t result() const { return result_value.load(); }
+
+  /// Waits until the command has been executed or the timeout is over
+  bool wait(uint32_t timeout_ms = 1000) {
+    uint32_t start = uptimeMs();
+    while (!isDone()) {
+      if (uptimeMs() - start > timeout_ms) return false;
+      delayMs(1);
+    }
+    return true;
+  }
+
+  void setPending() { state.store(Pending); }
+
+  void setDone(error_t result) {
+    result_value.store(result);
+    state.store(Done);
+    if (callback != nullptr) callback(result, ref);
+  }
+
+ protected:
+  std::atomic<int> state{Idle};
+  std::atomic<int> result_value{RESULT_OK};
+  void (*callback)(error_t result, void *ref) = nullptr;
+  void *ref = nullptr;
+};
+
+/**
+ * @brief Queued operation: either a register write or a call of a driver
+ * operation (e.g. setVolume) which is then executed by the worker.
+ */
+struct I2CCommand {
+  /// driver operation: if defined it is called instead of the register write
+  error_t (*op)(void *ref, int arg) = nullptr;
+  void *ref = nullptr;
+  int arg = 0;
+  /// register write
+  i2c_bus_handle_t bus = nullptr;
+  int addr = 0;
+  RegWrite reg_write{0, 0};
+  uint8_t reglen = 1;
+  uint8_t datalen = 1;
+  /// optional completion handle
+  I2CCompletion *completion = nullptr;
+
+  /// Creates a command which calls a driver operation
+  static I2CCommand call(error_t (*op)(void *ref, int arg), void *ref, int arg,
+                         I2CCompletion *completion = nullptr) {
+    I2CCommand cmd;
+    cmd.op = op;
+    cmd.ref = ref;
+    cmd.arg = arg;
+    cmd.completion = completion;
+    return cmd;
+  }
+
+  /// Executes the command synchronously and completes the handle
+  error_t execute() {
+    error_t rc;
+    if (op != nullptr) {
+      rc = op(ref, arg);
+    } else {
+      rc = i2c_bus_write_batch(bus, addr, &reg_write, 1, reglen, datalen);
+    }
+    if (completion != nullptr) completion->setDone(rc);
+    return rc;
+  }
+};
+
+/**
+ * @brief Bounded lock free I2C command queue: the commands are executed by a
+ * worker task (FreeRTOS task on ESP32, std::thread on the desktop). On other
+ * platforms begin() returns false and you need to call process() yourself
+ * e.g. in the loop.
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class I2CCommandQueue {
+ public:
+  I2CCommandQueue() = default;
+  ~I2CCommandQueue() { end(); }
+
+  /// Starts the worker task
+  bool begin(int priority = 1, int stack_size = 3072) {
+    if (is_running) return true;
+    is_running = true;
+#if defined(ESP32)
+    is_stopped = false;
+    if (xTaskCreate(task, "i2c_queue", stack_size, this, priority,
+                    &task_handle) != pdPASS) {
+      AD_LOGE("I2CCommandQueue: xTaskCreate");
+      is_running = false;
+      return false;
+    }
+    return true;
+#elif defined(I2C_QUEUE_STD_THREAD)
+    (void)priority;
+    (void)stack_size;
+    worker = std::thread([this]() { task(this); });
+    return true;
+#else
+    (void)priority;
+    (void)stack_size;
+    AD_LOGW("I2CCommandQueue: no worker - call process()");
+    is_running = false;
+    return false;
+#endif
+  }
+
+  /// Stops the worker task: queued commands are still executed
+  void end() {
+    if (!is_running) return;
+    is_running = false;
+#if defined(ESP32)
+    xTaskNotifyGive(task_handle);
+    while (!is_stopped) delayMs(1);
+    task_handle = nullptr;
+#elif defined(I2C_QUEUE_STD_THREAD)
+    notify();
+    if (worker.joinable()) worker.join();
+#endif
+    process();
+  }
+
+  /// Adds a command: returns false if the queue is full
+  bool enqueue(const I2CCommand &cmd) {
+    if (cmd.completion != nullptr) cmd.completion->setPending();
+    if (!queue.push(cmd)) {
+      AD_LOGE("I2CCommandQueue full: increase I2C_QUEUE_SIZE");
+      if (cmd.completion != nullptr) cmd.completion->setDone(RESULT_FAIL);
+      return false;
+    }
+    notify();
+    return true;
+  }
+
+  /// Executes the queued commands: returns the number of executed commands
+  int process(int max = -1) {
+    int count = 0;
+    I2CCommand cmd;
+    while ((max < 0 || count < max) && queue.pop(cmd)) {
+      if (cmd.execute() != RESULT_OK) error_count++;
+      count++;
+    }
+    return count;
+  }
+
+  /// Returns true if no commands are waiting
+  bool isEmpty() const { return queue.isEmpty(); }
+
+  /// Number of commands that have failed
+  uint32_t errorCount() const { return error_count.load(); }
+
+ protected:
+  LockFreeQueue<I2CCommand, I2C_QUEUE_SIZE> queue;
+  std::atomic<bool> is_running{false};
+  std::atomic<uint32_t> error_count{0};
+#if defined(ESP32)
+  TaskHandle_t task_handle = nullptr;
+  std::atomic<bool> is_stopped{false};
+
+  static void task(void *ref) {
+    I2CCommandQueue *self = (I2CCommandQueue *)ref;
+    while (self->is_running) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      self->process();
+    }
+    self->is_stopped = true;
+    vTaskDelete(nullptr);
+  }
+
+  void notify() {
+    if (task_handle != nullptr) xTaskNotifyGive(task_handle);
+  }
+#elif defined(I2C_QUEUE_STD_THREAD)
+  std::thread worker;
+  std::mutex mtx;
+  std::condition_variable cv;
+
+  static void task(I2CCommandQueue *self) {
+    while (self->is_running) {
+      {
+        std::unique_lock<std::mutex> lock(self->mtx);
+        self->cv.wait(lock, [self]() {
+          return !self->is_running || !self->queue.isEmpty();
+        });
+      }
+      self->process();
+    }
+  }
+
+  void notify() {
+    // the lock makes sure that the worker can't miss the notification
+    std::lock_guard<std::mutex> lock(mtx);
+    cv.notify_one();
+  }
+#else
+  void notify() {}
+#endif
+};
+
+}  // namespace audio_driver
@@ -0,0 +1,169 @@
+#pragma once
+#include <stdint.h>
+
+#include "DriverCommon.h"
+#include "Platforms/API_I2C.h"
+#include "Platforms/I2CBurstWriter.h"
+
+namespace audio_driver {
+
+/**
+ * @brief Currently selected register page and book of a paged I2C device
+ * (e.g. TI codecs): it is shared by all driver instances that access the
+ * same bus/address, so that redundant select writes can be dropped.
+ * -1 means unknown.
+ */
+struct I2CPageState {
+  i2c_bus_handle_t bus = nullptr;
+  int addr = -1;
+  int16_t page = -1;
+  int16_t book = -1;
+};
+
+/// Provides the page state of the device: if the table is full we return a
+/// scratch entry which is always unknown, so that the select is never skipped
+inline I2CPageState &i2c_page_state(i2c_bus_handle_t bus, int addr) {
+  // function local statics: C++11 has no inline variables
+  static I2CPageState states[I2C_MAX_DEVICES];
+  static I2CPageState untracked;
+  I2CPageState *free_entry = nullptr;
+  for (auto &state : states) {
+    if (state.bus == bus && state.addr == addr) return state;
+    if (free_entry == nullptr && state.bus == nullptr) free_entry = &state;
+  }
+  if (free_entry == nullptr) {
+    untracked = I2CPageState{};
+    return untracked;
+  }
+  free_entry->bus = bus;
+  free_entry->addr = addr;
+  free_entry->page = -1;
+  free_entry->book = -1;
+  return *free_entry;
+}
+
+/// Forgets the selected page and book: e.g. after a failed transfer
+inline void i2c_bus_invalidate_page(i2c_bus_handle_t bus, int addr) {
+  I2CPageState &state = i2c_page_state(bus, addr);
+  state.page = -1;
+  state.book = -1;
+}
+
+/// Defines the selected page and book w/o bus access: e.g. after a soft
+/// reset, which selects page 0 and book 0
+inline void i2c_bus_set_page(i2c_bus_handle_t bus, int addr, int page = 0,
+                             int book = 0) {
+  I2CPageState &state = i2c_page_state(bus, addr);
+  state.page = page;
+  state.book = book;
+}
+
+/// Selects the register page: the write is skipped if the page is already
+/// selected
+inline error_t i2c_bus_select_page(i2c_bus_handle_t bus, int addr,
+                                   uint8_t page_reg, uint8_t page) {
+  I2CPageState &state = i2c_page_state(bus, addr);
+  if (state.page == page) return RESULT_OK;
+  if (i2c_bus_write_bytes(bus, addr, &page_reg, 1, &page, 1) != RESULT_OK) {
+    state.page = -1;
+    return RESULT_FAIL;
+  }
+  state.page = page;
+  return RESULT_OK;
+}
+
+/// Selects the register book: the book register is on page 0, so page 0 is
+/// selected first. The write is skipped if the book is already selected.
+inline error_t i2c_bus_select_book(i2c_bus_handle_t bus, int addr,
+                                   uint8_t page_reg, uint8_t book_reg,
+                                   uint8_t book) {
+  I2CTransaction transaction(bus);
+  I2CPageState &state = i2c_page_state(bus, addr);
+  if (state.book == book) return RESULT_OK;
+  if (i2c_bus_select_page(bus, addr, page_reg, 0) != RESULT_OK)
+    return RESULT_FAIL;
+  if (i2c_bus_write_bytes(bus, addr, &book_reg, 1, &book, 1) != RESULT_OK) {
+    state.book = -1;
+    return RESULT_FAIL;
+  }
+  state.book = book;
+  return RESULT_OK;
+}
+
+/**
+ * @brief Collects register writes of a paged device and sends them grouped
+ * by page: each page is selected only once and consecutive registers within
+ * a page are combined into bursts. The order of the writes within a page is
+ * kept.
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class I2CPagedWriter {
+ public:
+  I2CPagedWriter(i2c_bus_handle_t bus, int addr, uint8_t page_reg,
+                 const I2CBurstTrait &trait)
+      : bus(bus), addr(addr), page_reg(page_reg), trait(trait) {}
+
+  ~I2CPagedWriter() { flush(); }
+
+  /// Queues a register write: the queue is sent when it is full
+  error_t write(uint8_t page, uint8_t reg, uint8_t value) {
+    if (len >= I2C_MAX_BURST) flush();
+    entries[len++] = {page, reg, value};
+    return result;
+  }
+
+  /// Sends the queued writes: returns RESULT_FAIL if any transfer failed
+  error_t flush() {
+    if (len == 0) return result;
+    I2CTransaction transaction(bus);
+    sortByPage();
+    I2CBurstWriter writer(bus, addr, trait);
+    int page = -1;
+    bool page_ok = false;
+    for (int j = 0; j < len; j++) {
+      if (entries[j].page != page) {
+        if (writer.flush() != RESULT_OK) result = RESULT_FAIL;
+        page = entries[j].page;
+        page_ok = i2c_bus_select_page(bus, addr, page_reg, page) == RESULT_OK;
+        if (!page_ok) result = RESULT_FAIL;
+      }
+      // never write to the wrong page
+      if (page_ok) writer.write(entries[j].reg, entries[j].value);
+    }
+    if (writer.flush() != RESULT_OK) result = RESULT_FAIL;
+    // a failed burst leaves the device in an unknown state
+    if (result != RESULT_OK) i2c_bus_invalidate_page(bus, addr);
+    len = 0;
+    return result;
+  }
+
+ protected:
+  struct Entry {
+    uint8_t page;
+    uint8_t reg;
+    uint8_t value;
+  };
+  i2c_bus_handle_t bus;
+  int addr;
+  uint8_t page_reg;
+  I2CBurstTrait trait;
+  Entry entries[I2C_MAX_BURST];
+  int len = 0;
+  error_t result = RESULT_OK;
+
+  /// stable insertion sort, so that the order within a page is kept
+  void sortByPage() {
+    for (int j = 1; j < len; j++) {
+      Entry entry = entries[j];
+      int k = j - 1;
+      while (k >= 0 && entries[k].page > entry.page) {
+        entries[k + 1] = entries[k];
+        k--;
+      }
+      entries[k + 1] = entry;
+    }
+  }
+};
+
+}  // namespace audio_driver
@@ -156,12 +156,17 @@ struct InfoI2C : public I2CConfig {
   bool begin() {
     if (set_active) {
       AD_LOGD("PinsI2C::begin for function %d on port %d", (int)function, port);
-      return i2c_bus_create(this) == RESULT_OK;
+      if (i2c_bus_create(this) != RESULT_OK) return false;
+      i2c_bus_add_device(*this);
+      if (auto_clock) i2c_bus_tune_clock(*this);
+      i2c_bus_set_error_policy(*this);
     }
     return true;
   }
   void end() {
-    if (set_active) i2c_bus_delete(p_wire);
+    if (!set_active) return;
+    i2c_bus_remove_device(*this);
+    i2c_bus_delete(p_wire);
   }
 };
 
@@ -0,0 +1,512 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "DriverCommon.h"
+#include "Platforms/API_I2C.h"
+#include "Platforms/StateBlob.h"
+
+namespace audio_driver {
+
+/// Access properties of a register (see RegDesc)
+enum RegFlags : uint8_t {
+  /// changed by the chip (status, faults, self clearing bits): never cached
+  REG_VOLATILE = 0x01,
+  /// can not be read back
+  REG_WRITE_ONLY = 0x02,
+  /// can not be written
+  REG_READ_ONLY = 0x04,
+  /// reading has side effects (e.g. clear on read): skipped by diagnostics
+  REG_PRECIOUS = 0x08,
+  /// writes trigger an action (e.g. power up or a state machine start), so
+  /// they are never deferred and are sent after the pending writes
+  REG_ORDERED = 0x10,
+};
+
+/// Describes the access properties of a register: registers that are not
+/// listed are plain cacheable read/write registers
+struct RegDesc {
+  uint16_t reg;
+  uint8_t flags;
+};
+
+/// Returns true if the descriptors are sorted by register, unique, below
+/// reg_count and consistent: to be used in a static_assert
+template <size_t M>
+constexpr bool reg_desc_valid(const RegDesc (&list)[M], size_t reg_count,
+                              size_t j = 0) {
+  // recursive: C++11 constexpr functions can not contain loops
+  return j >= M ||
+         (list[j].reg < reg_count &&
+          (j == 0 || list[j].reg > list[j - 1].reg) &&
+          !((list[j].flags & REG_WRITE_ONLY) &&
+            (list[j].flags & REG_READ_ONLY)) &&
+          reg_desc_valid(list, reg_count, j + 1));
+}
+
+/// Provides the RegFlags of the register from the sorted descriptors: 0 if
+/// it is not described
+template <size_t M>
+inline uint8_t reg_desc_flags(const RegDesc (&list)[M], size_t reg) {
+  for (size_t j = 0; j < M && list[j].reg <= reg; j++) {
+    if (list[j].reg == reg) return list[j].flags;
+  }
+  return 0;
+}
+
+/// Register flags of a RegMap w/o descriptors: all registers are plain
+/// cacheable read/write registers
+struct RegNoFlags {
+  static uint8_t flags(size_t reg) { return 0; }
+};
+
+/**
+ * @brief Shadow cache of the registers of a chip: writes go through to the
+ * bus, unchanged values are not written again, cached values are read w/o bus
+ * access and masked updates only need a bus read if the register is not known
+ * yet. The bus access is provided by the driver via callbacks, so that any
+ * register encoding (e.g. 7 bit address + 9 bit value) can be supported.
+ * Registers >= N are not cached. The optional FlagsT provides the RegFlags
+ * of a register with a static uint8_t flags(size_t reg): e.g. from a
+ * function local RegDesc list with reg_desc_flags(). It defines the
+ * volatile, write only, read only, precious and ordered registers. In
+ * deferred mode (beginDeferred()) the writes only update the cache until
+ * flush() is called: writes which must not be merged (REG_ORDERED registers
+ * and writeForced()) first send the pending writes.
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+template <typename AddrT, typename ValT, size_t N,
+          class FlagsT = RegNoFlags>
+class RegMap {
+ public:
+  /// writes the value to the register: returns RESULT_OK or RESULT_FAIL
+  typedef error_t (*WriteCallback)(void *ref, AddrT reg, ValT value);
+  /// reads the value of the register: returns RESULT_OK or RESULT_FAIL
+  typedef error_t (*ReadCallback)(void *ref, AddrT reg, ValT *value);
+  /// writes a list of registers (e.g. with i2c_bus_write_batch())
+  typedef error_t (*BatchWriteCallback)(void *ref, const RegWrite *list,
+                                        int n);
+
+  RegMap(void *ref, WriteCallback write_cb, ReadCallback read_cb = nullptr,
+         BatchWriteCallback batch_cb = nullptr)
+      : ref(ref), write_cb(write_cb), read_cb(read_cb), batch_cb(batch_cb) {
+    invalidate();
+  }
+
+  /// Writes the register: the bus access is skipped if the cached value is
+  /// the same
+  error_t write(AddrT reg, ValT value) {
+    if (isCached(reg) && values[reg] == value) return RESULT_OK;
+    if (deferred && (size_t)reg < N &&
+        !(flags(reg) & (REG_VOLATILE | REG_READ_ONLY | REG_ORDERED))) {
+      set(reg, value);
+      dirty[reg / 8] |= (1 << (reg % 8));
+      return RESULT_OK;
+    }
+    return writeForced(reg, value);
+  }
+
+  /// Writes the register even if the value is unchanged (e.g. to trigger an
+  /// action): this is never deferred, but in deferred mode the pending writes
+  /// are sent first to keep the order
+  error_t writeForced(AddrT reg, ValT value) {
+    if (flags(reg) & REG_READ_ONLY) {
+      AD_LOGE("RegMap: register 0x%x is read only", (int)reg);
+      return RESULT_FAIL;
+    }
+    error_t rc = deferred ? writeDirty() : RESULT_OK;
+    if (write_cb(ref, reg, value) == RESULT_OK) {
+      set(reg, value);
+      clearDirty(reg);
+    } else {
+      invalidate(reg);
+      rc = RESULT_FAIL;
+    }
+    return rc;
+  }
+
+  /// Writes a list of registers in one batch (see BatchWriteCallback): in
+  /// deferred mode only the cache is updated
+  error_t writeBatch(const RegWrite *list, int n) {
+    if (deferred) {
+      error_t rc = RESULT_OK;
+      for (int j = 0; j < n; j++) {
+        if (write((AddrT)list[j].reg, (ValT)list[j].value) != RESULT_OK)
+          rc = RESULT_FAIL;
+      }
+      return rc;
+    }
+    error_t rc = writeList(list, n);
+    if (rc == RESULT_OK) {
+      set(list, n, rc);
+      for (int j = 0; j < n; j++) clearDirty((AddrT)list[j].reg);
+    }
+    return rc;
+  }
+
+  /// Starts the deferred mode: writes of cacheable registers only update the
+  /// cache and mark them as dirty, so that multiple writes to the same
+  /// register collapse into one
+  void beginDeferred() { deferred = true; }
+
+  /// Returns true if we are in deferred mode
+  bool isDeferred() const { return deferred; }
+
+  /// Ends the deferred mode and writes the dirty registers sorted by address
+  /// in batches of I2C_MAX_BURST
+  error_t flush() {
+    deferred = false;
+    return writeDirty();
+  }
+
+  /// Returns true if the register was written in deferred mode and has not
+  /// been flushed yet
+  bool isDirty(AddrT reg) const {
+    if ((size_t)reg >= N) return false;
+    return dirty[reg / 8] & (1 << (reg % 8));
+  }
+
+  /// Provides the cached value: the register is only read from the bus if it
+  /// is not known yet
+  error_t read(AddrT reg, ValT *value) {
+    if (isCached(reg)) {
+      *value = values[reg];
+      return RESULT_OK;
+    }
+    return readUncached(reg, value);
+  }
+
+  /// Reads the register from the bus and updates the cache
+  error_t readUncached(AddrT reg, ValT *value) {
+    if (read_cb == nullptr || (flags(reg) & REG_WRITE_ONLY) || isDirty(reg)) {
+      // write only chip or not flushed: we can only report the last written
+      // value
+      *value = isCached(reg) ? values[reg] : 0;
+      return isCached(reg) ? RESULT_OK : RESULT_FAIL;
+    }
+    error_t rc = read_cb(ref, reg, value);
+    if (rc == RESULT_OK) {
+      set(reg, *value);
+    } else {
+      invalidate(reg);
+    }
+    return rc;
+  }
+
+  /// Replaces the bits defined by the mask with the bits of value
+  error_t update(AddrT reg, ValT mask, ValT value) {
+    ValT current = 0;
+    if (read(reg, &current) != RESULT_OK) return RESULT_FAIL;
+    return write(reg, (ValT)((current & ~mask) | (value & mask)));
+  }
+
+  /// Defines the value of a register w/o bus access (e.g. the reset default)
+  void set(AddrT reg, ValT value) {
+    if ((size_t)reg >= N || (flags(reg) & REG_VOLATILE)) return;
+    values[reg] = value;
+    valid[reg / 8] |= (1 << (reg % 8));
+  }
+
+  /// Defines the values of consecutive registers w/o bus access (e.g. after a
+  /// block read)
+  void set(AddrT first, const ValT *list, int n) {
+    for (int j = 0; j < n; j++) set((AddrT)(first + j), list[j]);
+  }
+
+  /// Updates the cache after a batch write (i2c_bus_write_batch()): on a
+  /// failure we do not know which registers were written
+  void set(const RegWrite *list, int n, error_t rc) {
+    for (int j = 0; j < n; j++) {
+      if (rc == RESULT_OK) {
+        set((AddrT)list[j].reg, (ValT)list[j].value);
+      } else {
+        invalidate((AddrT)list[j].reg);
+      }
+    }
+  }
+
+  /// Returns true if the value of the register is known
+  bool isCached(AddrT reg) const {
+    if ((size_t)reg >= N) return false;
+    return valid[reg / 8] & (1 << (reg % 8));
+  }
+
+  /// Provides the cached value or 0 if it is not known
+  ValT cached(AddrT reg) const { return isCached(reg) ? values[reg] : 0; }
+
+  /// Provides the RegFlags of the register
+  static uint8_t flags(AddrT reg) {
+    return (size_t)reg < N ? FlagsT::flags((size_t)reg) : 0;
+  }
+
+  /// Returns true if the register can be read w/o side effects (e.g. to
+  /// dump the registers)
+  bool isReadable(AddrT reg) const {
+    if (read_cb == nullptr) return false;
+    return !(flags(reg) & (REG_WRITE_ONLY | REG_PRECIOUS));
+  }
+
+  /// Defines the power-on values of the N registers (e.g. a constexpr table
+  /// from the datasheet): used by resync()
+  void setPowerOnDefaults(const ValT *list) { defaults = list; }
+
+  /// Defines the callback used by resync() to write multiple registers: by
+  /// default the registers are written one by one
+  void setBatchWrite(BatchWriteCallback cb) { batch_cb = cb; }
+
+  /// Writes the cached values back to the chip after it has been reset or
+  /// power cycled: only the registers which differ from the power-on
+  /// defaults are sent in batches of I2C_MAX_BURST. W/o defaults all cached
+  /// registers are sent. The registers of the last list (e.g. clock select,
+  /// power up and state machine start) are sent at the end in the order of
+  /// the chip's init sequence, all others before them sorted by address.
+  error_t resync(const AddrT *last = nullptr, int last_count = 0) {
+    RegWrite list[I2C_MAX_BURST];
+    int n = 0;
+    error_t rc = RESULT_OK;
+    for (size_t reg = 0; reg < N; reg++) {
+      bool is_last = false;
+      for (int j = 0; j < last_count; j++) {
+        if ((size_t)last[j] == reg) is_last = true;
+      }
+      if (!is_last) addResync(list, n, rc, reg);
+    }
+    for (int j = 0; j < last_count; j++) addResync(list, n, rc, last[j]);
+    if (n > 0) rc |= writeList(list, n);
+    return rc;
+  }
+
+  /// Serialises the cached registers (w/o the read only ones): the number of
+  /// registers, the value size, a bitmap of the saved registers and their
+  /// values
+  error_t save(StateBlobWriter &out) const {
+    out.put16((uint16_t)N);
+    out.put8((uint8_t)sizeof(ValT));
+    uint8_t saved[(N + 7) / 8] = {};
+    for (size_t reg = 0; reg < N; reg++) {
+      if (isCached(reg) && !(flags(reg) & REG_READ_ONLY))
+        saved[reg / 8] |= (1 << (reg % 8));
+    }
+    for (size_t j = 0; j < sizeof(saved); j++) out.put8(saved[j]);
+    for (size_t reg = 0; reg < N; reg++) {
+      if (saved[reg / 8] & (1 << (reg % 8)))
+        out.putValue(values[reg], sizeof(ValT));
+    }
+    return out ? RESULT_OK : RESULT_FAIL;
+  }
+
+  /// Replaces the cache with the registers serialised by save(): the chip is
+  /// not accessed, so call resync() to write them
+  error_t load(StateBlobReader &in) {
+    if (in.get16() != N || in.get8() != sizeof(ValT) || !in) {
+      AD_LOGE("RegMap: state does not match the register map");
+      return RESULT_FAIL;
+    }
+    uint8_t saved[(N + 7) / 8];
+    for (size_t j = 0; j < sizeof(saved); j++) saved[j] = in.get8();
+    invalidate();
+    for (size_t reg = 0; reg < N; reg++) {
+      if (saved[reg / 8] & (1 << (reg % 8)))
+        set((AddrT)reg, (ValT)in.getValue(sizeof(ValT)));
+    }
+    if (!in) {
+      invalidate();
+      return RESULT_FAIL;
+    }
+    return RESULT_OK;
+  }
+
+  /// Forgets all values: e.g. after a reset of the chip
+  void invalidate() {
+    for (size_t j = 0; j < sizeof(valid); j++) valid[j] = 0;
+    for (size_t j = 0; j < sizeof(dirty); j++) dirty[j] = 0;
+  }
+
+  /// Forgets the value of a single register
+  void invalidate(AddrT reg) {
+    if ((size_t)reg >= N) return;
+    valid[reg / 8] &= ~(1 << (reg % 8));
+    clearDirty(reg);
+  }
+
+ protected:
+  void *ref;
+  WriteCallback write_cb;
+  ReadCallback read_cb;
+  BatchWriteCallback batch_cb;
+  const ValT *defaults = nullptr;
+  ValT values[N] = {};
+  uint8_t valid[(N + 7) / 8];
+  uint8_t dirty[(N + 7) / 8];
+  bool deferred = false;
+
+  /// Adds the register to the list of resync(): a full list is written
+  void addResync(RegWrite *list, int &n, error_t &rc, size_t reg) {
+    if (!isCached(reg) || (flags(reg) & REG_READ_ONLY)) return;
+    if (defaults != nullptr && values[reg] == defaults[reg]) return;
+    list[n++] = {(uint16_t)reg, (uint16_t)values[reg]};
+    if (n == I2C_MAX_BURST) {
+      rc |= writeList(list, n);
+      n = 0;
+    }
+  }
+
+  /// Writes the dirty registers sorted by address in batches of
+  /// I2C_MAX_BURST
+  error_t writeDirty() {
+    RegWrite list[I2C_MAX_BURST];
+    int n = 0;
+    error_t rc = RESULT_OK;
+    for (size_t reg = 0; reg < N; reg++) {
+      if (!isDirty(reg)) continue;
+      clearDirty(reg);
+      list[n++] = {(uint16_t)reg, (uint16_t)values[reg]};
+      if (n == I2C_MAX_BURST) {
+        rc |= writeList(list, n);
+        n = 0;
+      }
+    }
+    if (n > 0) rc |= writeList(list, n);
+    return rc;
+  }
+
+  void clearDirty(AddrT reg) {
+    if ((size_t)reg < N) dirty[reg / 8] &= ~(1 << (reg % 8));
+  }
+
+  error_t writeList(const RegWrite *list, int n) {
+    error_t rc = RESULT_OK;
+    if (batch_cb != nullptr) {
+      rc = batch_cb(ref, list, n);
+    } else {
+      for (int j = 0; j < n; j++) {
+        if (write_cb(ref, (AddrT)list[j].reg, (ValT)list[j].value) !=
+            RESULT_OK)
+          rc = RESULT_FAIL;
+      }
+    }
+    // on a failure we do not know the content of the registers any more
+    if (rc != RESULT_OK) set(list, n, rc);
+    return rc;
+  }
+};
+
+/**
+ * @brief Register shadow of a write only chip which keeps only the registers
+ * that differ from the power-on defaults. DefaultsT provides the default of a
+ * register with static ValT get(size_t reg), e.g. from a function local
+ * static constexpr table of N values (flash) which is shared by all instances,
+ * so the RAM per instance is a bitmap of N bits plus Capacity values, which
+ * are stored in register order. Registers >= N are not cached.
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+template <typename AddrT, typename ValT, size_t N, size_t Capacity,
+          class DefaultsT>
+class SparseRegMap {
+  static_assert(Capacity <= 255, "Capacity must be below 256");
+
+ public:
+  /// writes the value to the register: returns RESULT_OK or RESULT_FAIL
+  typedef error_t (*WriteCallback)(void *ref, AddrT reg, ValT value);
+
+  SparseRegMap(void *ref, WriteCallback write_cb)
+      : ref(ref), write_cb(write_cb) {
+    reset();
+  }
+
+  /// Writes the register: the bus access is skipped if the value is unchanged
+  error_t write(AddrT reg, ValT value) {
+    if ((size_t)reg < N && read(reg) == value) return RESULT_OK;
+    return writeForced(reg, value);
+  }
+
+  /// Writes the register even if the value is unchanged (e.g. a reset)
+  error_t writeForced(AddrT reg, ValT value) {
+    // make sure that we can store the value before we change the chip
+    if ((size_t)reg < N && !isChanged(reg) &&
+        value != DefaultsT::get(reg) && count >= Capacity) {
+      AD_LOGE("SparseRegMap: no space for register 0x%x", (int)reg);
+      return RESULT_FAIL;
+    }
+    error_t rc = write_cb(ref, reg, value);
+    if (rc == RESULT_OK) set(reg, value);
+    return rc;
+  }
+
+  /// Provides the last written value or the power-on default
+  ValT read(AddrT reg) const {
+    if ((size_t)reg >= N) return 0;
+    return isChanged(reg) ? values[index(reg)] : DefaultsT::get(reg);
+  }
+
+  /// Replaces the bits defined by the mask with the bits of value
+  error_t update(AddrT reg, ValT mask, ValT value) {
+    return write(reg, (ValT)((read(reg) & ~mask) | (value & mask)));
+  }
+
+  /// All registers are back at their power-on defaults: e.g. after a reset
+  void reset() {
+    for (size_t j = 0; j < sizeof(changed); j++) changed[j] = 0;
+    count = 0;
+  }
+
+  /// Writes all registers which differ from the power-on defaults: e.g.
+  /// after the chip has been power cycled
+  error_t resync() {
+    error_t rc = RESULT_OK;
+    for (size_t reg = 0; reg < N; reg++) {
+      if (isChanged(reg) && write_cb(ref, (AddrT)reg, read(reg)) != RESULT_OK)
+        rc = RESULT_FAIL;
+    }
+    return rc;
+  }
+
+  /// Returns true if the register differs from the power-on default
+  bool isChanged(AddrT reg) const {
+    if ((size_t)reg >= N) return false;
+    return changed[reg / 8] & (1 << (reg % 8));
+  }
+
+  /// Number of registers which differ from the power-on defaults
+  size_t changedCount() const { return count; }
+
+ protected:
+  void *ref;
+  WriteCallback write_cb;
+  uint8_t changed[(N + 7) / 8];
+  uint8_t count = 0;
+  ValT values[Capacity];
+
+  /// position of the register in values: number of changed registers below
+  size_t index(AddrT reg) const {
+    size_t result = 0;
+    for (size_t j = 0; j < (size_t)reg; j++) {
+      if (isChanged(j)) result++;
+    }
+    return result;
+  }
+
+  void set(AddrT reg, ValT value) {
+    if ((size_t)reg >= N) return;
+    size_t pos = index(reg);
+    if (isChanged(reg)) {
+      if (value != DefaultsT::get(reg)) {
+        values[pos] = value;
+        return;
+      }
+      // back at the default: remove the entry
+      for (size_t j = pos; j + 1 < count; j++) values[j] = values[j + 1];
+      changed[reg / 8] &= ~(1 << (reg % 8));
+      count--;
+    } else if (value != DefaultsT::get(reg) && count < Capacity) {
+      for (size_t j = count; j > pos; j--) values[j] = values[j - 1];
+      values[pos] = value;
+      changed[reg / 8] |= (1 << (reg % 8));
+      count++;
+    }
+  }
+};
+
+}  // namespace audio_driver
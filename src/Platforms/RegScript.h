@@ -0,0 +1,345 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "DriverCommon.h"
+#include "Platforms/API_Delay.h"
+#include "Platforms/API_I2C.h"
+#include "Platforms/I2CBurstWriter.h"
+
+namespace audio_driver {
+
+/// Operations of a RegStep
+enum RegOp : uint8_t {
+  /// end of the script
+  REG_OP_END = 0,
+  /// writes the value to the register
+  REG_OP_WRITE,
+  /// writes the runtime argument with the index arg to the register
+  REG_OP_WRITE_ARG,
+  /// replaces the bits defined by the mask with the bits of value
+  REG_OP_UPDATE,
+  /// waits for value ms
+  REG_OP_DELAY,
+  /// selects the page value with the page register reg
+  REG_OP_PAGE,
+  /// waits up to arg ms until (register & mask) == value
+  REG_OP_POLL,
+};
+
+/**
+ * @brief One step of a register script. Scripts are function local static
+ * constexpr arrays (flash) which are built with the script_...() functions,
+ * terminated by script_end() and checked with reg_script_valid() in a
+ * static_assert.
+ */
+struct RegStep {
+  uint8_t op;
+  /// runtime argument index (REG_OP_WRITE_ARG) or timeout in ms (REG_OP_POLL)
+  uint8_t arg;
+  uint16_t reg;
+  uint16_t value;
+  uint16_t mask;
+};
+
+constexpr RegStep script_write(uint16_t reg, uint16_t value) {
+  return {REG_OP_WRITE, 0, reg, value, 0xFFFF};
+}
+
+/// Writes a value that is only known at runtime: args[idx] of
+/// reg_script_run()
+constexpr RegStep script_write_arg(uint16_t reg, uint8_t idx) {
+  return {REG_OP_WRITE_ARG, idx, reg, 0, 0xFFFF};
+}
+
+constexpr RegStep script_update(uint16_t reg, uint16_t mask, uint16_t value) {
+  return {REG_OP_UPDATE, 0, reg, value, mask};
+}
+
+constexpr RegStep script_delay(uint16_t ms) {
+  return {REG_OP_DELAY, 0, 0, ms, 0};
+}
+
+constexpr RegStep script_page(uint16_t page_reg, uint16_t page) {
+  return {REG_OP_PAGE, 0, page_reg, page, 0xFFFF};
+}
+
+constexpr RegStep script_poll(uint16_t reg, uint16_t mask, uint16_t value,
+                              uint8_t timeout_ms) {
+  return {REG_OP_POLL, timeout_ms, reg, value, mask};
+}
+
+constexpr RegStep script_end() { return {REG_OP_END, 0, 0, 0, 0}; }
+
+/// Checks a single step of a script (see reg_script_valid())
+constexpr bool reg_step_valid(const RegStep &step, size_t reg_count,
+                              uint32_t value_max, size_t arg_count) {
+  return step.op == REG_OP_DELAY ||
+         (step.op <= REG_OP_POLL && step.reg < reg_count &&
+          step.value <= value_max && (step.value & ~step.mask) == 0 &&
+          step.mask != 0 && (step.mask <= value_max || step.mask == 0xFFFF) &&
+          (step.op != REG_OP_WRITE_ARG || step.arg < arg_count) &&
+          (step.op != REG_OP_POLL || step.arg != 0));
+}
+
+/// Checks the script from step j on: page is the selected page
+template <size_t M>
+constexpr bool reg_script_valid_from(const RegStep (&script)[M],
+                                     size_t reg_count, uint32_t value_max,
+                                     size_t arg_count, size_t j,
+                                     uint16_t page) {
+  // recursive: C++11 constexpr functions can not contain loops
+  return j < M &&
+         (script[j].op == REG_OP_END
+              ? j == M - 1 && page == 0
+              : reg_step_valid(script[j], reg_count, value_max, arg_count) &&
+                    reg_script_valid_from(script, reg_count, value_max,
+                                          arg_count, j + 1,
+                                          script[j].op == REG_OP_PAGE
+                                              ? script[j].value
+                                              : page));
+}
+
+/// Returns true if the script is terminated by a single script_end(), all
+/// registers are below reg_count, the values fit into value_size bytes, the
+/// masks cover the values, polls have a timeout, the runtime arguments are
+/// below arg_count and page 0 is selected again at the end: to be used in a
+/// static_assert
+template <size_t M>
+constexpr bool reg_script_valid(const RegStep (&script)[M], size_t reg_count,
+                                size_t value_size, size_t arg_count = 0) {
+  return reg_script_valid_from(script, reg_count,
+                               value_size >= 2 ? 0xFFFF : 0xFF, arg_count, 0,
+                               0);
+}
+
+/**
+ * @brief Register access used by reg_script_run(): consecutive writes are
+ * collected and sent with write_batch, so a RegMap can skip unchanged values
+ * and combine them in deferred mode. Use reg_script_bus() for a RegMap.
+ */
+struct RegScriptBus {
+  void *ref = nullptr;
+  /// writes a list of registers
+  error_t (*write_batch)(void *ref, const RegWrite *list, int n) = nullptr;
+  /// masked update (read-modify-write)
+  error_t (*update)(void *ref, uint16_t reg, uint16_t mask,
+                    uint16_t value) = nullptr;
+  /// reads the register from the chip (polling)
+  error_t (*read)(void *ref, uint16_t reg, uint16_t *value) = nullptr;
+  /// selects a register page
+  error_t (*select_page)(void *ref, uint16_t page_reg,
+                         uint16_t page) = nullptr;
+};
+
+/// Provides the RegScriptBus for a RegMap: a page select invalidates the
+/// cache, because the cached values belong to the previous page
+template <class Map>
+RegScriptBus reg_script_bus(Map &regs) {
+  RegScriptBus bus;
+  bus.ref = &regs;
+  bus.write_batch = [](void *ref, const RegWrite *list, int n) -> error_t {
+    return ((Map *)ref)->writeBatch(list, n);
+  };
+  bus.update = [](void *ref, uint16_t reg, uint16_t mask,
+                  uint16_t value) -> error_t {
+    Map *map = (Map *)ref;
+    return map->update(reg, mask, value);
+  };
+  bus.read = [](void *ref, uint16_t reg, uint16_t *value) -> error_t {
+    decltype(((Map *)ref)->cached(0)) tmp = 0;
+    error_t rc = ((Map *)ref)->readUncached(reg, &tmp);
+    *value = tmp;
+    return rc;
+  };
+  bus.select_page = [](void *ref, uint16_t page_reg,
+                       uint16_t page) -> error_t {
+    Map *map = (Map *)ref;
+    error_t rc = map->writeForced(page_reg, page);
+    map->invalidate();
+    return rc;
+  };
+  return bus;
+}
+
+/// Waits until (register & mask) == value: returns RESULT_FAIL on a timeout
+inline error_t reg_script_poll(const RegScriptBus &bus, const RegStep &step) {
+  if (bus.read == nullptr) return RESULT_FAIL;
+  bool ok = wait_until(
+      [&]() {
+        uint16_t value = 0;
+        return bus.read(bus.ref, step.reg, &value) == RESULT_OK &&
+               (value & step.mask) == step.value;
+      },
+      step.arg);
+  if (ok) return RESULT_OK;
+  AD_LOGE("reg_script: timeout polling reg 0x%x", step.reg);
+  return RESULT_FAIL;
+}
+
+/// Executes the script: consecutive writes are sent as one batch of up to
+/// I2C_MAX_BURST registers. All steps are executed even if a step fails.
+inline error_t reg_script_run(const RegScriptBus &bus, const RegStep *script,
+                              const uint16_t *args = nullptr) {
+  RegWrite list[I2C_MAX_BURST];
+  int n = 0;
+  int batches = 0;
+  error_t rc = RESULT_OK;
+  auto flush = [&]() {
+    if (n == 0) return;
+    rc |= bus.write_batch(bus.ref, list, n);
+    batches++;
+    n = 0;
+  };
+  const RegStep *step = script;
+  for (; step->op != REG_OP_END; step++) {
+    switch (step->op) {
+      case REG_OP_WRITE:
+      case REG_OP_WRITE_ARG: {
+        uint16_t value =
+            step->op == REG_OP_WRITE ? step->value : args[step->arg];
+        AD_LOGD("reg_script: write 0x%x = 0x%x", step->reg, value);
+        list[n++] = {step->reg, value};
+        if (n == I2C_MAX_BURST) flush();
+      } break;
+      case REG_OP_UPDATE:
+        flush();
+        if (bus.update == nullptr) {
+          rc = RESULT_FAIL;
+          break;
+        }
+        AD_LOGD("reg_script: update 0x%x mask 0x%x = 0x%x", step->reg,
+                step->mask, step->value);
+        rc |= bus.update(bus.ref, step->reg, step->mask, step->value);
+        break;
+      case REG_OP_DELAY:
+        flush();
+        AD_LOGD("reg_script: delay %d ms", step->value);
+        delayMs(step->value);
+        break;
+      case REG_OP_PAGE:
+        flush();
+        if (bus.select_page == nullptr) {
+          AD_LOGE("reg_script: page select not supported");
+          rc = RESULT_FAIL;
+          break;
+        }
+        AD_LOGD("reg_script: page %d", step->value);
+        rc |= bus.select_page(bus.ref, step->reg, step->value);
+        break;
+      case REG_OP_POLL:
+        flush();
+        rc |= reg_script_poll(bus, *step);
+        break;
+    }
+  }
+  flush();
+  AD_LOGD("reg_script: %d steps in %d batches", (int)(step - script),
+          batches);
+  return rc == RESULT_OK ? RESULT_OK : RESULT_FAIL;
+}
+
+/// Meta entries of a RegCfgEntry table (TI PPC3 register dumps)
+static constexpr uint8_t CFG_META_SWITCH = 255;
+static constexpr uint8_t CFG_META_DELAY = 254;
+static constexpr uint8_t CFG_META_BURST = 253;
+static constexpr uint8_t CFG_END_1 = 0xaa;
+static constexpr uint8_t CFG_END_2 = 0xcc;
+static constexpr uint8_t CFG_END_3 = 0xee;
+
+/// Entry of a TI PPC3 configuration table for 8 bit registers: offset is the
+/// register or one of the CFG_META_... commands
+struct RegCfgEntry {
+  uint8_t offset;
+  uint8_t value;
+};
+
+/// Index of the table entry after the one at j: a burst is skipped. M + 1 if
+/// the burst is empty or exceeds the table.
+template <size_t M>
+constexpr size_t reg_cfg_table_next(const RegCfgEntry (&table)[M], size_t j) {
+  // register + data bytes are stored in (value / 2) + 1 entries
+  return j >= M                               ? j
+         : table[j].offset != CFG_META_BURST ? j + 1
+         : table[j].value == 0 || j + (table[j].value / 2) + 1 >= M
+             ? M + 1
+             : j + (table[j].value / 2) + 2;
+}
+
+/// Advances n entries from j: the recursion depth is only log2(n), so that
+/// long tables stay below the constexpr depth limit of the compiler
+template <size_t M>
+constexpr size_t reg_cfg_table_skip(const RegCfgEntry (&table)[M], size_t j,
+                                    size_t n) {
+  return n <= 1 ? reg_cfg_table_next(table, j)
+                : reg_cfg_table_skip(table, reg_cfg_table_skip(table, j, n / 2),
+                                     n - n / 2);
+}
+
+/// Returns true if all bursts of the configuration table are within the
+/// table: to be used in a static_assert
+template <size_t M>
+constexpr bool reg_cfg_table_valid(const RegCfgEntry (&table)[M]) {
+  return reg_cfg_table_skip(table, 0, M) == M;
+}
+
+/// Non-blocking reg_cfg_table_run(): sends the TI PPC3 configuration table
+/// from pos up to the next CFG_META_DELAY and returns its delay in ms,
+/// STEP_DONE at the end of the table or STEP_FAILED. pos is updated.
+inline int reg_cfg_table_step(i2c_bus_handle_t bus, int addr,
+                              const I2CBurstTrait &trait,
+                              const RegCfgEntry *conf_buf, int size,
+                              int &pos) {
+  error_t ret = RESULT_OK;
+  I2CBurstWriter writer(bus, addr, trait);
+  int delay_ms = STEP_DONE;
+  while (pos < size && delay_ms == STEP_DONE) {
+    int i = pos;
+    switch (conf_buf[i].offset) {
+      case CFG_META_SWITCH:
+        // Used in legacy applications.  Ignored here.
+        break;
+      case CFG_META_DELAY:
+        delay_ms = conf_buf[i].value;
+        break;
+      case CFG_META_BURST: {
+        ret |= writer.flush();
+        // the register and the data bytes are already contiguous
+        I2CIoVec iov = {&conf_buf[i + 1].offset,
+                        (size_t)conf_buf[i].value + 1};
+        ret |= i2c_bus_writev(bus, addr, &iov, 1);
+        i += (conf_buf[i].value / 2) + 1;
+      } break;
+      case CFG_END_1:
+        if (i + 2 < size && CFG_END_2 == conf_buf[i + 1].offset &&
+            CFG_END_3 == conf_buf[i + 2].offset) {
+          AD_LOGI("End of configuration table: %d", i);
+        }
+        break;
+      default:
+        writer.write(conf_buf[i].offset, conf_buf[i].value);
+        break;
+    }
+    pos = i + 1;
+  }
+  ret |= writer.flush();
+  if (ret != RESULT_OK) return STEP_FAILED;
+  if (delay_ms == STEP_DONE) {
+    AD_LOGI("%s: write %d reg done", __FUNCTION__, pos);
+  }
+  return delay_ms;
+}
+
+/// Sends a TI PPC3 configuration table: consecutive register entries are
+/// combined into bursts
+inline error_t reg_cfg_table_run(i2c_bus_handle_t bus, int addr,
+                                 const I2CBurstTrait &trait,
+                                 const RegCfgEntry *conf_buf, int size) {
+  int pos = 0;
+  bool ok = run_steps([&](int step) {
+    return reg_cfg_table_step(bus, addr, trait, conf_buf, size, pos);
+  });
+  return ok ? RESULT_OK : RESULT_FAIL;
+}
+
+}  // namespace audio_driver
@@ -0,0 +1,138 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "DriverCommon.h"
+#include "Platforms/API_Delay.h"
+#include "Platforms/API_I2C.h"
+#include "Platforms/I2CBurstWriter.h"
+#include "Platforms/I2CPagedRegs.h"
+#include "Platforms/RegStreamFormat.h"
+
+namespace audio_driver {
+
+/**
+ * @brief Provides the bytes of a register stream (see RegStreamFormat.h):
+ * implement it e.g. to read a tuning file in chunks
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class RegStreamSource {
+ public:
+  /// Reads up to len bytes: returns the number of bytes that were read
+  virtual size_t read(uint8_t *data, size_t len) = 0;
+};
+
+/**
+ * @brief Register stream in memory: flash that is mapped into the address
+ * space or a memory mapped file
+ */
+class RegStreamMemory : public RegStreamSource {
+ public:
+  RegStreamMemory(const uint8_t *data, size_t len) : data(data), len(len) {}
+
+  size_t read(uint8_t *out, size_t n) override {
+    if (n > len - pos) n = len - pos;
+    memcpy(out, data + pos, n);
+    pos += n;
+    return n;
+  }
+
+ protected:
+  const uint8_t *data;
+  size_t len;
+  size_t pos = 0;
+};
+
+/// Adds the n data bytes of a burst or fill to the writer, which combines
+/// consecutive registers into bursts of up to I2C_MAX_BURST bytes
+inline error_t reg_stream_write(I2CBurstWriter &writer, RegStreamSource &src,
+                                uint8_t reg, int n, bool fill) {
+  uint8_t buffer[16];
+  if (fill) {
+    if (src.read(buffer, 1) != 1) return RESULT_FAIL;
+    for (int j = 0; j < n; j++) writer.write(reg++, buffer[0]);
+    return RESULT_OK;
+  }
+  while (n > 0) {
+    int len = n < (int)sizeof(buffer) ? n : (int)sizeof(buffer);
+    if (src.read(buffer, len) != (size_t)len) return RESULT_FAIL;
+    for (int j = 0; j < len; j++) writer.write(reg++, buffer[j]);
+    n -= len;
+  }
+  return RESULT_OK;
+}
+
+/// Executes a register stream created by tools/regstream: the RAM needed is
+/// one burst of I2C_MAX_BURST bytes, independent of the size of the stream.
+/// Page and book selects go through the shared page state (I2CPagedRegs.h).
+/// A malformed stream is aborted with RESULT_FAIL.
+inline error_t reg_stream_run(i2c_bus_handle_t bus, int addr,
+                              RegStreamSource &src) {
+  uint8_t header[REG_STREAM_HEADER_SIZE];
+  if (src.read(header, sizeof(header)) != sizeof(header) ||
+      header[0] != REG_STREAM_MAGIC_0 || header[1] != REG_STREAM_MAGIC_1 ||
+      header[2] != REG_STREAM_VERSION) {
+    AD_LOGE("reg_stream: invalid header");
+    return RESULT_FAIL;
+  }
+  const uint8_t page_reg = header[4];
+  const uint8_t book_reg = header[5];
+  I2CBurstTrait trait{(header[3] & REG_STREAM_AUTO_INCREMENT) != 0, 0,
+                      I2C_MAX_BURST};
+  I2CBurstWriter writer(bus, addr, trait);
+  error_t rc = RESULT_OK;
+  int ops = 0;
+  uint8_t op = 0;
+  while (src.read(&op, 1) == 1) {
+    uint8_t arg[2];
+    if (op == REG_STREAM_END) {
+      rc |= writer.flush();
+      AD_LOGI("reg_stream: %d operations", ops);
+      return rc == RESULT_OK ? RESULT_OK : RESULT_FAIL;
+    }
+    ops++;
+    if (op < REG_STREAM_PAGE) {
+      bool fill = op >= REG_STREAM_FILL;
+      int n = fill ? (op & 0x3F) + 1 : op;
+      if (src.read(arg, 1) != 1) break;
+      if (reg_stream_write(writer, src, arg[0], n, fill) != RESULT_OK) break;
+      continue;
+    }
+    rc |= writer.flush();
+    switch (op) {
+      case REG_STREAM_PAGE:
+        if (page_reg == REG_STREAM_NONE || src.read(arg, 1) != 1) break;
+        rc |= i2c_bus_select_page(bus, addr, page_reg, arg[0]);
+        continue;
+      case REG_STREAM_BOOK:
+        if (page_reg == REG_STREAM_NONE || book_reg == REG_STREAM_NONE ||
+            src.read(arg, 1) != 1)
+          break;
+        rc |= i2c_bus_select_book(bus, addr, page_reg, book_reg, arg[0]);
+        continue;
+      case REG_STREAM_DELAY:
+        if (src.read(arg, 2) != 2) break;
+        delayMs(arg[0] | (arg[1] << 8));
+        continue;
+      case REG_STREAM_INVALIDATE:
+        i2c_bus_invalidate_page(bus, addr);
+        continue;
+    }
+    break;
+  }
+  writer.flush();
+  AD_LOGE("reg_stream: malformed stream at operation %d (0x%x)", ops, op);
+  i2c_bus_invalidate_page(bus, addr);
+  return RESULT_FAIL;
+}
+
+/// Executes a register stream from memory (flash or a memory mapped file)
+inline error_t reg_stream_run(i2c_bus_handle_t bus, int addr,
+                              const uint8_t *data, size_t len) {
+  RegStreamMemory src(data, len);
+  return reg_stream_run(bus, addr, src);
+}
+
+}  // namespace audio_driver
@@ -0,0 +1,47 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Binary register stream created by tools/regstream from vendor tuning files
+ * (e.g. TI PPC3 dumps) and executed by reg_stream_run() (RegStream.h). This
+ * header has no dependencies, so that it can be used by the host tool.
+ *
+ * Header: 'R', 'S', version, flags, page register, book register (0xFF =
+ * none)
+ *
+ * Opcodes:
+ * - 0x00: end of stream
+ * - 0x01..0x7F: n = op data bytes to consecutive registers: reg, data[n]
+ * - 0x80..0xBF: the same value to n = (op & 0x3F) + 1 consecutive registers:
+ *   reg, value
+ * - 0xC0: select page: page
+ * - 0xC1: select book: book
+ * - 0xC2: delay: ms (little endian 16 bit)
+ * - 0xC3: the selected page and book are unknown (e.g. after a soft reset)
+ *
+ * Consecutive registers are sent as one I2C burst if the chip supports the
+ * auto increment (REG_STREAM_AUTO_INCREMENT).
+ */
+
+namespace audio_driver {
+
+static constexpr uint8_t REG_STREAM_MAGIC_0 = 'R';
+static constexpr uint8_t REG_STREAM_MAGIC_1 = 'S';
+static constexpr uint8_t REG_STREAM_VERSION = 1;
+static constexpr size_t REG_STREAM_HEADER_SIZE = 6;
+/// header flag: the chip increments the register address during a burst
+static constexpr uint8_t REG_STREAM_AUTO_INCREMENT = 0x01;
+/// no page or book register
+static constexpr uint8_t REG_STREAM_NONE = 0xFF;
+
+static constexpr uint8_t REG_STREAM_END = 0x00;
+static constexpr uint8_t REG_STREAM_BURST_MAX = 0x7F;
+static constexpr uint8_t REG_STREAM_FILL = 0x80;
+static constexpr int REG_STREAM_FILL_MAX = 64;
+static constexpr uint8_t REG_STREAM_PAGE = 0xC0;
+static constexpr uint8_t REG_STREAM_BOOK = 0xC1;
+static constexpr uint8_t REG_STREAM_DELAY = 0xC2;
+static constexpr uint8_t REG_STREAM_INVALIDATE = 0xC3;
+
+}  // namespace audio_driver
@@ -0,0 +1,140 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace audio_driver {
+
+/// Magic number and version of the blobs created by AudioDriver::saveState()
+static constexpr uint16_t STATE_BLOB_MAGIC = 0x5341;  // "AS"
+static constexpr uint8_t STATE_BLOB_VERSION = 2;
+/// magic (2), version (1), payload size (2), crc (2)
+static constexpr size_t STATE_BLOB_HEADER_SIZE = 7;
+
+/// CRC-16/CCITT of the data
+inline uint16_t state_blob_crc(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t j = 0; j < len; j++) {
+    crc ^= (uint16_t)data[j] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief Writes little endian values into a state blob: writing beyond the
+ * end of the buffer is ignored and marks the writer as failed.
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class StateBlobWriter {
+ public:
+  StateBlobWriter(uint8_t *buffer, size_t len) : buffer(buffer), len(len) {}
+
+  /// Reserves the header: the payload follows
+  void beginBlob() { pos = STATE_BLOB_HEADER_SIZE; }
+
+  /// Fills in the header: returns the size of the blob or 0 on failure
+  size_t endBlob() {
+    size_t payload = pos - STATE_BLOB_HEADER_SIZE;
+    if (!ok || buffer == nullptr || pos < STATE_BLOB_HEADER_SIZE ||
+        payload > 0xFFFF)
+      return 0;
+    uint16_t crc = state_blob_crc(buffer + STATE_BLOB_HEADER_SIZE, payload);
+    size_t end = pos;
+    pos = 0;
+    put16(STATE_BLOB_MAGIC);
+    put8(STATE_BLOB_VERSION);
+    put16((uint16_t)payload);
+    put16(crc);
+    pos = end;
+    return pos;
+  }
+
+  void put8(uint8_t value) {
+    if (pos >= len || buffer == nullptr) {
+      ok = false;
+      return;
+    }
+    buffer[pos++] = value;
+  }
+
+  void put16(uint16_t value) {
+    put8(value & 0xFF);
+    put8(value >> 8);
+  }
+
+  /// Writes a value of 1, 2 or 4 bytes
+  void putValue(uint32_t value, size_t size) {
+    for (size_t j = 0; j < size; j++) put8((value >> (8 * j)) & 0xFF);
+  }
+
+  /// Number of bytes written so far
+  size_t size() const { return pos; }
+
+  /// Returns false if the buffer was too small
+  operator bool() const { return ok; }
+
+ protected:
+  uint8_t *buffer;
+  size_t len;
+  size_t pos = 0;
+  bool ok = true;
+};
+
+/**
+ * @brief Reads little endian values from a state blob: reading beyond the
+ * end returns 0 and marks the reader as failed.
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class StateBlobReader {
+ public:
+  StateBlobReader(const uint8_t *buffer, size_t len)
+      : buffer(buffer), len(len) {}
+
+  /// Checks the header (magic, version, size and crc) and limits the reader
+  /// to the payload
+  bool beginBlob() {
+    pos = 0;
+    if (get16() != STATE_BLOB_MAGIC || get8() != STATE_BLOB_VERSION)
+      return false;
+    size_t payload = get16();
+    uint16_t crc = get16();
+    if (!ok || pos + payload > len) return false;
+    len = pos + payload;
+    return state_blob_crc(buffer + pos, payload) == crc;
+  }
+
+  uint8_t get8() {
+    if (pos >= len || buffer == nullptr) {
+      ok = false;
+      return 0;
+    }
+    return buffer[pos++];
+  }
+
+  uint16_t get16() {
+    uint16_t result = get8();
+    return result | (uint16_t)(get8() << 8);
+  }
+
+  /// Reads a value of 1, 2 or 4 bytes
+  uint32_t getValue(size_t size) {
+    uint32_t result = 0;
+    for (size_t j = 0; j < size; j++) result |= (uint32_t)get8() << (8 * j);
+    return result;
+  }
+
+  /// Returns false if we tried to read beyond the end
+  operator bool() const { return ok; }
+
+ protected:
+  const uint8_t *buffer;
+  size_t len;
+  size_t pos = 0;
+  bool ok = true;
+};
+
+}  // namespace audio_driver
@@ -20,7 +20,9 @@ namespace audio_driver {
  * @brief Driver for the TCA9555 I2C I/O expander (header-only).
  *
  * Provides methods to configure pin direction, read and write pin states, and
- * manage the I2C bus.
+ * manage the I2C bus. The output, polarity and configuration registers are
+ * shadowed, so that pin changes need only one write of the register pair
+ * (both ports) and unchanged values are not written at all.
  */
 class TCA9555 : public API_GPIO {
  public:
@@ -49,7 +51,10 @@ class TCA9555 : public API_GPIO {
     AD_LOGI("TCA9555 address: 0x%02X", i2c_default_address);
     i2c_bus_create(&cfg);
     bus = cfg.p_wire;
-    return bus != nullptr;
+    if (bus == nullptr) return false;
+    // the expander keeps its state over a reset of the microcontroller
+    if (!sync()) AD_LOGW("TCA9555 could not read the registers");
+    return true;
   }
 
   /**
@@ -76,25 +81,71 @@ class TCA9555 : public API_GPIO {
       AD_LOGE("TCA9555 invalid pin: %d", pin);
       return false;
     }
-    uint8_t port = pin / 8;
-    uint8_t bit = pin % 8;
-    uint8_t reg = 0x02 + port;  // Output port 0 or 1
-    uint8_t out;
-    if (!i2c_read(i2c_default_address, reg, &out, 1)) {
-      AD_LOGE("TCA9555 read failed for pin: %d", pin);
-      return false;
-    }
-    if (value)
-      out |= (1 << bit);
-    else
-      out &= ~(1 << bit);
-    bool rc = i2c_write(i2c_default_address, reg, &out, 1);
+    uint16_t mask = 1 << pin;
+    bool rc = writePort(mask, value ? mask : 0);
     if (!rc) {
       AD_LOGE("TCA9555 write failed for pin: %d", pin);
     }
     return rc;
   }
 
+  /**
+   * @brief Set multiple output pins in one transaction.
+   * @param mask Pins to change: bit 0 = pin 0 ... bit 15 = pin 15.
+   * @param value New state of the selected pins.
+   * @return true if successful, false otherwise.
+   */
+  bool writePort(uint16_t mask, uint16_t value) {
+    return updatePair(REG_OUTPUT, output, mask, value);
+  }
+
+  /**
+   * @brief Define the direction of multiple pins in one transaction.
+   * @param mask Pins to change: bit 0 = pin 0 ... bit 15 = pin 15.
+   * @param input Bits set to 1 are inputs, 0 are outputs.
+   * @return true if successful, false otherwise.
+   */
+  bool setPortMode(uint16_t mask, uint16_t input) {
+    return updatePair(REG_CONFIG, config, mask, input);
+  }
+
+  /**
+   * @brief Define the input polarity inversion of multiple pins.
+   * @param mask Pins to change: bit 0 = pin 0 ... bit 15 = pin 15.
+   * @param invert Bits set to 1 invert the input.
+   * @return true if successful, false otherwise.
+   */
+  bool setPolarity(uint16_t mask, uint16_t invert) {
+    return updatePair(REG_POLARITY, polarity, mask, invert);
+  }
+
+  /**
+   * @brief Read the input state of all pins in one transaction.
+   * @return the input ports (bit 0 = pin 0) or 0 on error.
+   */
+  uint16_t readPort() {
+    uint16_t result = 0;
+    readPair(REG_INPUT, result);
+    return result;
+  }
+
+  /// Provides the shadowed output register (bit 0 = pin 0)
+  uint16_t getOutput() const { return output; }
+
+  /**
+   * @brief Reload the shadows of the output, polarity and configuration
+   * registers from the chip: e.g. after the expander has been reset.
+   * @return true if successful, false otherwise.
+   */
+  bool sync() {
+    if (bus == nullptr) return false;
+    I2CTransaction transaction(bus);
+    is_synced = readPair(REG_OUTPUT, output) &&
+                readPair(REG_POLARITY, polarity) &&
+                readPair(REG_CONFIG, config);
+    return is_synced;
+  }
+
   /**
    * @brief Read the input state of a pin.
    * @param pin Pin number (0-15).
@@ -126,19 +177,10 @@ class TCA9555 : public API_GPIO {
       return;
     }
     bool input = (mode == INPUT || mode == INPUT_PULLUP);
-    uint8_t port = pin / 8;
-    uint8_t bit = pin % 8;
-    uint8_t reg = 0x06 + port;  // Configuration port 0 or 1
-    uint8_t cfg;
-    if (!i2c_read(i2c_default_address, reg, &cfg, 1)) {
-      AD_LOGE("TCA9555 read failed for pin: %d", pin);
-      return;
+    uint16_t mask = 1 << pin;
+    if (!setPortMode(mask, input ? mask : 0)) {
+      AD_LOGE("TCA9555 pinMode failed for pin: %d", pin);
     }
-    if (input)
-      cfg |= (1 << bit);
-    else
-      cfg &= ~(1 << bit);
-    i2c_write(i2c_default_address, reg, &cfg, 1);
   }
 
   /// Not supported
@@ -155,8 +197,46 @@ class TCA9555 : public API_GPIO {
   void setI2CAddress(uint8_t address) { i2c_default_address = address; }
 
  protected:
+  /// first register of the register pairs (port 0, port 1)
+  static constexpr uint8_t REG_INPUT = 0x00;
+  static constexpr uint8_t REG_OUTPUT = 0x02;
+  static constexpr uint8_t REG_POLARITY = 0x04;
+  static constexpr uint8_t REG_CONFIG = 0x06;
   uint8_t i2c_default_address;
   i2c_bus_handle_t bus = nullptr;
+  // shadows with the power-on defaults
+  uint16_t output = 0xFFFF;
+  uint16_t polarity = 0x0000;
+  uint16_t config = 0xFFFF;
+  bool is_synced = false;
+
+  /// Reads port 0 and port 1 of a register pair in one transaction
+  bool readPair(uint8_t reg, uint16_t& value) {
+    uint8_t data[2];
+    if (!i2c_read(i2c_default_address, reg, data, 2)) return false;
+    value = data[0] | (data[1] << 8);
+    return true;
+  }
+
+  /// Updates the bits of the shadow selected by the mask and writes both
+  /// ports (command byte + 2 data bytes) if the value has changed
+  bool updatePair(uint8_t reg, uint16_t& shadow, uint16_t mask,
+                  uint16_t value) {
+    if (bus == nullptr) return false;
+    I2CTransaction transaction(bus);
+    // we need the current state of the other pins
+    if (!is_synced && !sync()) return false;
+    uint16_t new_value = (shadow & ~mask) | (value & mask);
+    if (new_value == shadow) return true;
+    uint8_t data[2] = {(uint8_t)(new_value & 0xFF), (uint8_t)(new_value >> 8)};
+    if (!i2c_write(i2c_default_address, reg, data, 2)) {
+      // we do not know the state of the chip any more
+      is_synced = false;
+      return false;
+    }
+    shadow = new_value;
+    return true;
+  }
 
   /**
    * @brief Helper to read bytes from the TCA9555 using the platform I2C
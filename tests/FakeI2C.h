@@ -0,0 +1,131 @@
+#pragma once
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "AudioDriver.h"
+
+/// Stops the test with the failed condition
+#define TEST_ASSERT(cond)                                          \
+  do {                                                             \
+    if (!(cond)) {                                                 \
+      fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, \
+              #cond);                                              \
+      exit(1);                                                     \
+    }                                                              \
+  } while (0)
+
+namespace audio_driver {
+
+/// Write message seen on the simulated bus: the register followed by the data
+struct FakeMessage {
+  uint16_t addr;
+  std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Simulated I2C devices with 8 bit register addresses behind the
+ * Linux backend (i2c_linux_syscalls()): the writes are logged and reads are
+ * answered from a register file per device address, which tests can
+ * preset or replace with a read callback.
+ */
+class FakeI2C {
+ public:
+  static FakeI2C &instance() {
+    static FakeI2C fake;
+    return fake;
+  }
+
+  /// Replaces the system calls and provides the bus of port 1
+  i2c_bus_handle_t begin() {
+    i2c_linux_syscalls() = {fakeOpen, fakeClose, fakeIoctl, fakeSetClock};
+    I2CConfig cfg;
+    cfg.port = 1;
+    TEST_ASSERT(i2c_bus_create(&cfg) == RESULT_OK);
+    return cfg.p_wire;
+  }
+
+  /// Forgets the logged writes and the transfer count
+  void clear() {
+    writes.clear();
+    transfers = 0;
+  }
+
+  /// Index of the first write of the value to the 8 bit register at or after
+  /// from: -1 if not found
+  int find(uint8_t reg, uint8_t value, int from = 0) const {
+    for (size_t j = from; j < writes.size(); j++) {
+      const std::vector<uint8_t> &data = writes[j].data;
+      for (size_t k = 1; k < data.size(); k++) {
+        if ((uint8_t)(data[0] + k - 1) == reg && data[k] == value) return j;
+      }
+    }
+    return -1;
+  }
+
+  /// Index of the first write to the 8 bit register: -1 if not found
+  int find(uint8_t reg) const {
+    for (size_t j = 0; j < writes.size(); j++) {
+      const std::vector<uint8_t> &data = writes[j].data;
+      if (!data.empty() && reg >= data[0] && reg < data[0] + data.size() - 1)
+        return j;
+    }
+    return -1;
+  }
+
+  std::vector<FakeMessage> writes;
+  /// number of I2C_RDWR ioctls
+  int transfers = 0;
+  /// registers per 7 bit device address
+  uint8_t regs[128][256] = {};
+  /// optional: provides the value of a register read
+  uint8_t (*read_cb)(uint16_t addr, uint8_t reg) = nullptr;
+  /// clock set by i2c_raw_set_clock()
+  uint32_t clock = 100000;
+  /// transfers fail with EIO above this clock
+  uint32_t max_clock = 1000000;
+
+ protected:
+  static int fakeOpen(const char *path, int flags) { return 42; }
+  static int fakeClose(int fd) { return 0; }
+  static int fakeSetClock(int fd, uint32_t frequency) {
+    instance().clock = frequency;
+    return 0;
+  }
+
+  static int fakeIoctl(int fd, unsigned long request, void *arg) {
+    FakeI2C &self = instance();
+    struct ::i2c_rdwr_ioctl_data *data = (struct ::i2c_rdwr_ioctl_data *)arg;
+    self.transfers++;
+    if (self.clock > self.max_clock) {
+      errno = EIO;
+      return -1;
+    }
+    uint8_t reg = 0;
+    for (unsigned j = 0; j < data->nmsgs; j++) {
+      struct ::i2c_msg &msg = data->msgs[j];
+      uint16_t addr = msg.addr & 0x7F;
+      if (msg.flags & I2C_M_RD) {
+        for (int k = 0; k < msg.len; k++, reg++) {
+          msg.buf[k] = self.read_cb != nullptr ? self.read_cb(addr, reg)
+                                               : self.regs[addr][reg];
+        }
+        continue;
+      }
+      if (msg.len == 0) continue;
+      reg = msg.buf[0];
+      // a register address w/o data selects the register of a read
+      if (msg.len == 1) continue;
+      self.writes.push_back({addr, {msg.buf, msg.buf + msg.len}});
+      for (int k = 1; k < msg.len; k++) {
+        self.regs[addr][(uint8_t)(reg + k - 1)] = msg.buf[k];
+      }
+    }
+    return data->nmsgs;
+  }
+};
+
+}  // namespace audio_driver
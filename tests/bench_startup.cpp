@@ -0,0 +1,41 @@
+// Startup time of the drivers which poll status bits instead of waiting for
+// the worst case: the simulated status bits are ready immediately, so only
+// the remaining fixed delays are measured. Not executed by ctest.
+#include "FakeI2C.h"
+
+using namespace audio_driver;
+
+static const uint8_t AW88298_ADDR = 0x36;
+
+/// AW88298 reports its chip id 0x1852, all other registers read as 0
+static uint8_t readRegister(uint16_t addr, uint8_t reg) {
+  if (addr == AW88298_ADDR && reg == 0x00) return 0x18;
+  if (addr == AW88298_ADDR && reg == 0x01) return 0x52;
+  return 0;
+}
+
+template <class Function>
+static uint32_t measureMs(Function function) {
+  uint32_t start = uptimeMs();
+  function();
+  return uptimeMs() - start;
+}
+
+int main() {
+  FakeI2C &fake = FakeI2C::instance();
+  i2c_bus_handle_t bus = fake.begin();
+  fake.read_cb = readRegister;
+
+  AW88298 aw88298;
+  aw88298.setWire(bus);
+  printf("AW88298 begin: %u ms\n",
+         (unsigned)measureMs([&]() { aw88298.begin(); }));
+
+  WM8994 wm8994;
+  wm8994.setWire(bus);
+  printf("WM8994 init (headphone): %u ms\n",
+         (unsigned)measureMs([&]() {
+           wm8994.init(WM8994::OUTPUT_DEVICE_HEADPHONE, 70, 48000);
+         }));
+  return 0;
+}
@@ -0,0 +1,44 @@
+// beginAsync(): the settle delays are returned to the caller, so a virtual
+// clock is advanced by the total startup time w/o blocking
+#include "FakeI2C.h"
+
+using namespace audio_driver;
+
+/// Executes beginAsync() with poll(nowMs): returns the virtual time in ms
+static uint32_t beginVirtual(AudioDriver &driver, DriverDeviceInfo &pins) {
+  CodecConfig cfg;
+  uint32_t now = 0;
+  TEST_ASSERT(driver.beginAsync(cfg, pins));
+  while (driver.poll(now) == AudioDriver::BeginState::Busy) {
+    uint32_t wait = driver.pollDelay(now);
+    TEST_ASSERT(wait > 0);
+    now += wait;
+  }
+  TEST_ASSERT(driver.beginState() == AudioDriver::BeginState::Done);
+  return now;
+}
+
+int main() {
+  FakeI2C::instance().begin();
+  DriverDeviceInfo pins;
+  pins.addI2C(PinFunction::CODEC, -1, -1, 1);
+  uint32_t start = uptimeMs();
+
+  // reset, headphone and speaker power up
+  AudioDriverAC101Class ac101;
+  TEST_ASSERT(beginVirtual(ac101, pins) == 1000 + 100 + 10);
+
+  // power pin low and high, CFG_META_DELAY of the register table
+  AudioDriverTAS5805MClass tas5805m;
+  TEST_ASSERT(beginVirtual(tas5805m, pins) == 20 + 20 + 5);
+
+  // composite: the delays of the DAC and the ADC overlap, so the longer one
+  // counts and the poll time is passed on to both drivers
+  AudioDriverCombined combined(ac101, tas5805m);
+  TEST_ASSERT(beginVirtual(combined, pins) == 1000 + 100 + 10);
+
+  // no delay was spent in the drivers
+  TEST_ASSERT(uptimeMs() - start < 100);
+  printf("test_begin_async: ok\n");
+  return 0;
+}
@@ -0,0 +1,54 @@
+// Deferred register cache: writes which trigger an action must be sent in
+// order and must not be merged
+#include "FakeI2C.h"
+
+using namespace audio_driver;
+
+static FakeI2C &fake = FakeI2C::instance();
+
+/// The state machine restart of ES8388::start() is sent after the pending
+/// writes, even if the cache already holds the final value
+static void testES8388Restart(i2c_bus_handle_t bus) {
+  ES8388 es8388;
+  es8388.setWire(bus);
+  CodecConfig cfg;
+  TEST_ASSERT(es8388.init(&cfg, 0) == RESULT_OK);
+
+  fake.clear();
+  es8388.beginDeferred();
+  TEST_ASSERT(es8388.start(CODEC_MODE_LINE_IN) == RESULT_OK);
+  TEST_ASSERT(es8388.flush() == RESULT_OK);
+
+  const uint8_t chippower = 0x02, dac_control21 = 0x2B;
+  int mixer = fake.find(dac_control21, 0xC0);
+  int stop = fake.find(chippower, 0xF0);
+  TEST_ASSERT(mixer >= 0);
+  TEST_ASSERT(stop > mixer);
+  TEST_ASSERT(fake.find(chippower, 0x00, stop + 1) > stop);
+}
+
+/// ES8311: the state machine (REG00) is started after the clock manager
+/// setup in deferred mode
+static void testES8311Order(DriverDeviceInfo &pins) {
+  AudioDriverES8311Class driver;
+  driver.setDeferredConfig(true);
+  CodecConfig cfg;
+  fake.clear();
+  TEST_ASSERT(driver.begin(cfg, pins));
+  int csm_on = fake.find(0x00, 0x80);
+  TEST_ASSERT(csm_on >= 0);
+  for (uint8_t reg = 0x01; reg <= 0x05; reg++) {
+    TEST_ASSERT(fake.find(reg) >= 0 && fake.find(reg) < csm_on);
+  }
+}
+
+int main() {
+  i2c_bus_handle_t bus = fake.begin();
+  DriverDeviceInfo pins;
+  pins.addI2C(PinFunction::CODEC, -1, -1, 1);
+
+  testES8388Restart(bus);
+  testES8311Order(pins);
+  printf("test_deferred: ok\n");
+  return 0;
+}
@@ -0,0 +1,17 @@
+// wait_until(): the timeout is measured in ms and not in polls
+#include "FakeI2C.h"
+
+using namespace audio_driver;
+
+int main() {
+  int polls = 0;
+  uint32_t start = uptimeMs();
+  TEST_ASSERT(!wait_until([&]() { return ++polls < 0; }, 20));
+  TEST_ASSERT(uptimeMs() - start >= 20);
+
+  polls = 0;
+  TEST_ASSERT(wait_until([&]() { return ++polls == 3; }, 1000));
+  TEST_ASSERT(polls == 3);
+  printf("test_delay: ok\n");
+  return 0;
+}
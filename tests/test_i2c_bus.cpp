@@ -0,0 +1,87 @@
+// i2c_bus_delete(): the state of the bus is released, so that a new bus with
+// the same handle starts with the defaults. i2c_bus_tune_clock() keeps the
+// fastest clock that all devices pass and refuses buses with a device that
+// can not be verified.
+#include "FakeI2C.h"
+
+using namespace audio_driver;
+
+/// Creates the bus of the port with a clock and an error policy
+static i2c_bus_handle_t createBus(int port, uint32_t frequency) {
+  I2CConfig cfg{};
+  cfg.port = port;
+  TEST_ASSERT(i2c_bus_create(&cfg) == RESULT_OK);
+  cfg.frequency = frequency;
+  cfg.error_policy.max_retries = 7;
+  i2c_bus_set_error_policy(cfg);
+  return cfg.p_wire;
+}
+
+int main() {
+  FakeI2C::instance().begin();
+
+  // more buses than I2C_MAX_BUSES one after the other
+  i2c_bus_handle_t first = nullptr;
+  for (int port = 2; port < 2 + 3 * I2C_MAX_BUSES; port++) {
+    i2c_bus_handle_t bus = createBus(port, 400000);
+    TEST_ASSERT(i2c_bus_mutex(bus) != nullptr);
+    if (first == nullptr) first = bus;
+    i2c_bus_delete(bus);
+  }
+
+  // the handle is reused w/o the clock and the policy of the deleted bus
+  I2CConfig cfg{};
+  cfg.port = 9;
+  TEST_ASSERT(i2c_bus_create(&cfg) == RESULT_OK);
+  TEST_ASSERT(cfg.p_wire == first);
+  I2CBusState *state = i2c_bus_state(cfg.p_wire);
+  TEST_ASSERT(state != nullptr);
+  TEST_ASSERT(state->config.frequency == 0);
+  TEST_ASSERT(state->config.error_policy.max_retries != 7);
+
+  // a shared bus with a device w/o verify_reg is not tuned
+  I2CConfig codec = cfg;
+  codec.address = 0x18;
+  codec.verify_reg = 0x00;
+  I2CConfig amp = cfg;
+  amp.address = 0x34;
+  TEST_ASSERT(i2c_bus_add_device(codec) == RESULT_OK);
+  TEST_ASSERT(i2c_bus_add_device(amp) == RESULT_OK);
+  TEST_ASSERT(state->device_count == 2);
+  TEST_ASSERT(i2c_bus_tune_clock(codec) == RESULT_FAIL);
+  TEST_ASSERT(!state->clock_tuned);
+  i2c_bus_remove_device(amp);
+  TEST_ASSERT(state->device_count == 1);
+  TEST_ASSERT(state->devices[0].address == 0x18);
+
+  // the fastest clock that passes is kept and written back
+  FakeI2C &fake = FakeI2C::instance();
+  fake.regs[0x18][0x00] = 0x5A;
+  fake.max_clock = 400000;
+  TEST_ASSERT(i2c_bus_tune_clock(codec) == RESULT_OK);
+  TEST_ASSERT(codec.frequency == 400000);
+  TEST_ASSERT(fake.clock == 400000);
+  TEST_ASSERT(state->clock_tuned);
+  fake.max_clock = 1000000;
+  TEST_ASSERT(i2c_bus_tune_clock(codec) == RESULT_OK);
+  TEST_ASSERT(codec.frequency == 1000000);
+  TEST_ASSERT(fake.clock == 1000000);
+
+  // all devices must pass: a new device resets the clock until it is tuned
+  amp.verify_reg = 0x01;
+  amp.frequency = 100000;
+  fake.regs[0x34][0x01] = 0x20;
+  TEST_ASSERT(i2c_bus_add_device(amp) == RESULT_OK);
+  TEST_ASSERT(fake.clock == 100000);
+  TEST_ASSERT(!state->clock_tuned);
+  fake.max_clock = 400000;
+  TEST_ASSERT(i2c_bus_tune_clock(amp) == RESULT_OK);
+  TEST_ASSERT(amp.frequency == 400000);
+  TEST_ASSERT(fake.clock == 400000);
+  i2c_bus_remove_device(amp);
+  i2c_bus_remove_device(codec);
+  i2c_bus_delete(cfg.p_wire);
+  TEST_ASSERT(i2c_bus_state(cfg.p_wire)->device_count == 0);
+  printf("test_i2c_bus: ok\n");
+  return 0;
+}
@@ -0,0 +1,75 @@
+// I2CCommandQueue: the ...Async() methods are executed by the std::thread
+// worker on the simulated bus
+#include "FakeI2C.h"
+
+using namespace audio_driver;
+
+static FakeI2C &fake = FakeI2C::instance();
+
+static int callback_count = 0;
+static error_t callback_result = RESULT_FAIL;
+
+static void onDone(error_t result, void *ref) {
+  (void)ref;
+  callback_result = result;
+  callback_count++;
+}
+
+/// The worker executes the queued commands in order
+static void testWorker(DriverDeviceInfo &pins) {
+  AudioDriverES8311Class driver;
+  CodecConfig cfg;
+  TEST_ASSERT(driver.begin(cfg, pins));
+
+  I2CCommandQueue queue;
+  TEST_ASSERT(queue.begin());
+  driver.setCommandQueue(&queue);
+
+  fake.clear();
+  I2CCompletion first;
+  I2CCompletion last(onDone, nullptr);
+  TEST_ASSERT(driver.setVolumeAsync(10, &first));
+  TEST_ASSERT(driver.setMuteAsync(true));
+  TEST_ASSERT(driver.setVolumeAsync(90, &last));
+  TEST_ASSERT(last.wait(1000));
+  TEST_ASSERT(first.isDone() && first.result() == RESULT_OK);
+  TEST_ASSERT(last.result() == RESULT_OK);
+  TEST_ASSERT(callback_count == 1 && callback_result == RESULT_OK);
+  queue.end();
+
+  const uint8_t dac_volume = 0x32;
+  int vol1 = fake.find(dac_volume);
+  TEST_ASSERT(vol1 >= 0);
+  // the first volume was overwritten by the last one
+  const FakeMessage &msg = fake.writes[vol1];
+  TEST_ASSERT(msg.data[1] != fake.regs[msg.addr][dac_volume]);
+  TEST_ASSERT(queue.errorCount() == 0);
+}
+
+/// Without a worker the command stays pending and wait() times out after
+/// the requested time
+static void testTimeout() {
+  I2CCommandQueue queue;
+  I2CCompletion completion;
+  TEST_ASSERT(queue.enqueue(I2CCommand::call(
+      [](void *, int) { return RESULT_OK; }, nullptr, 0, &completion)));
+  TEST_ASSERT(completion.isPending());
+
+  uint32_t start = uptimeMs();
+  TEST_ASSERT(!completion.wait(20));
+  TEST_ASSERT(uptimeMs() - start >= 20);
+
+  TEST_ASSERT(queue.process() == 1);
+  TEST_ASSERT(completion.wait(0));
+}
+
+int main() {
+  fake.begin();
+  DriverDeviceInfo pins;
+  pins.addI2C(PinFunction::CODEC, -1, -1, 1);
+
+  testWorker(pins);
+  testTimeout();
+  printf("test_i2c_queue: ok\n");
+  return 0;
+}
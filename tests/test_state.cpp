@@ -0,0 +1,63 @@
+// saveState() / beginFromState(): the registers are replayed in the power-up
+// order of the chip
+#include "FakeI2C.h"
+
+using namespace audio_driver;
+
+static FakeI2C &fake = FakeI2C::instance();
+
+/// ES8311: the state machine (REG00) is started after the clock manager and
+/// the analog power up (REG0D) comes after the system registers
+static void testES8311Replay(DriverDeviceInfo &pins) {
+  uint8_t state[256];
+  size_t len = 0;
+  {
+    AudioDriverES8311Class driver;
+    CodecConfig cfg;
+    TEST_ASSERT(driver.begin(cfg, pins));
+    len = driver.saveState(state, sizeof(state));
+    TEST_ASSERT(len > 0);
+  }
+
+  AudioDriverES8311Class driver;
+  fake.clear();
+  TEST_ASSERT(driver.beginFromState(pins, state, len));
+  int csm_on = fake.find(0x00);
+  int power_up = fake.find(0x0D);
+  TEST_ASSERT(csm_on >= 0 && power_up > csm_on);
+  for (uint8_t reg = 0x01; reg <= 0x05; reg++) {
+    TEST_ASSERT(fake.find(reg) >= 0 && fake.find(reg) < csm_on);
+  }
+  TEST_ASSERT(fake.find(0x0E) < power_up && fake.find(0x14) < power_up);
+}
+
+/// The SD settings of the pins are restored from the blob
+static void testSDConfig(DriverDeviceInfo &pins) {
+  uint8_t state[256];
+  size_t len = 0;
+  {
+    AudioDriverES8311Class driver;
+    CodecConfig cfg;
+    cfg.sdmmc_active = true;
+    TEST_ASSERT(driver.begin(cfg, pins));
+    len = driver.saveState(state, sizeof(state));
+    TEST_ASSERT(len > 0);
+  }
+
+  pins.setSDMMCActive(false);
+  AudioDriverES8311Class driver;
+  TEST_ASSERT(driver.beginFromState(pins, state, len));
+  TEST_ASSERT(pins.isSDMMCActive());
+  pins.setSDMMCActive(false);
+}
+
+int main() {
+  fake.begin();
+  DriverDeviceInfo pins;
+  pins.addI2C(PinFunction::CODEC, -1, -1, 1);
+
+  testES8311Replay(pins);
+  testSDConfig(pins);
+  printf("test_state: ok\n");
+  return 0;
+}
@@ -0,0 +1,394 @@
+/**
+ * @brief Host tool which compiles vendor register dumps into the compact
+ * binary register stream of RegStreamFormat.h, which is executed by
+ * reg_stream_run().
+ *
+ * Supported input formats:
+ * - C tables of {register, value} pairs as created by TI PPC3 (e.g.
+ *   tas5805m_reg_cfg.h) incl. CFG_META_DELAY and CFG_META_BURST
+ * - TI .cfg scripts: "w <i2c addr> <reg> <value> [values...]", continuation
+ *   lines "> <values...>", "d <ms>" delays and "#" comments
+ *
+ * Consecutive registers are combined into bursts, runs of the same value are
+ * run-length encoded, redundant page and book selects are dropped and
+ * delays become delay opcodes.
+ *
+ * Usage: regstream [options] <input> <output>
+ *  --page-reg <reg>   page select register (e.g. 0x00 for TI)
+ *  --book-reg <reg>   book select register on page 0 (e.g. 0x7f for TI)
+ *  --reset-reg <reg>  soft reset register on page 0: forgets page and book
+ *  --table <name>     only parse the C table with this name
+ *  --name <name>      write a C++ header with this array name instead of a
+ *                     binary file
+ *  --no-burst         the chip does not auto increment the register: each
+ *                     register is sent in its own transfer
+ *
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "Platforms/RegStreamFormat.h"
+
+using namespace audio_driver;
+
+struct Options {
+  int page_reg = REG_STREAM_NONE;
+  int book_reg = REG_STREAM_NONE;
+  int reset_reg = -1;
+  bool burst = true;
+  std::string table;
+  std::string name;
+  std::string input;
+  std::string output;
+};
+
+/// One parsed operation: a register write or a delay
+struct Entry {
+  bool delay;
+  int reg;
+  int value;
+};
+
+static bool read_file(const std::string &path, std::string &content) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return false;
+  char buffer[4096];
+  size_t len;
+  while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    content.append(buffer, len);
+  fclose(file);
+  return true;
+}
+
+/// Removes // and /* */ comments
+static std::string strip_comments(const std::string &src) {
+  std::string result;
+  for (size_t j = 0; j < src.size(); j++) {
+    if (src.compare(j, 2, "//") == 0) {
+      while (j < src.size() && src[j] != '\n') j++;
+    } else if (src.compare(j, 2, "/*") == 0) {
+      size_t end = src.find("*/", j + 2);
+      j = end == std::string::npos ? src.size() : end + 1;
+      continue;
+    }
+    if (j < src.size()) result += src[j];
+  }
+  return result;
+}
+
+/// Parses a number or one of the CFG_ constants of the PPC3 tables
+static bool parse_value(std::string token, int &value) {
+  static const struct {
+    const char *name;
+    int value;
+  } names[] = {{"CFG_META_SWITCH", 255}, {"CFG_META_DELAY", 254},
+               {"CFG_META_BURST", 253},  {"CFG_END_1", 0xaa},
+               {"CFG_END_2", 0xcc},      {"CFG_END_3", 0xee}};
+  size_t start = token.find_first_not_of(" \t\r\n");
+  size_t end = token.find_last_not_of(" \t\r\n");
+  if (start == std::string::npos) return false;
+  token = token.substr(start, end - start + 1);
+  for (auto &entry : names) {
+    if (token == entry.name) {
+      value = entry.value;
+      return true;
+    }
+  }
+  char *rest = nullptr;
+  value = (int)strtol(token.c_str(), &rest, 0);
+  return rest != token.c_str() && *rest == 0;
+}
+
+/// Parses the {register, value} pairs of a PPC3 C table
+static bool parse_table(const std::string &content, const Options &opt,
+                        std::vector<Entry> &entries) {
+  std::string src = strip_comments(content);
+  size_t pos = 0;
+  size_t end = src.size();
+  if (!opt.table.empty()) {
+    pos = src.find(opt.table + "[]");
+    if (pos == std::string::npos) {
+      fprintf(stderr, "table %s not found\n", opt.table.c_str());
+      return false;
+    }
+    pos = src.find('{', pos) + 1;
+    end = src.find("};", pos);
+  }
+  std::vector<int> pairs;
+  while (true) {
+    size_t open = src.find('{', pos);
+    if (open == std::string::npos || open >= end) break;
+    size_t close = src.find('}', open);
+    size_t comma = src.find(',', open);
+    pos = close + 1;
+    if (close == std::string::npos || comma > close) continue;
+    int reg, value;
+    if (!parse_value(src.substr(open + 1, comma - open - 1), reg) ||
+        !parse_value(src.substr(comma + 1, close - comma - 1), value))
+      continue;
+    pairs.push_back(reg);
+    pairs.push_back(value);
+  }
+  for (size_t j = 0; j + 1 < pairs.size(); j += 2) {
+    int reg = pairs[j], value = pairs[j + 1];
+    if (reg == 255 || reg == 0xaa || reg == 0xcc || reg == 0xee) continue;
+    if (reg == 254) {
+      entries.push_back({true, 0, value});
+    } else if (reg == 253) {
+      // burst: register followed by value data bytes, stored in pairs
+      size_t data = j + 2;
+      if (data + value + 1 > pairs.size()) {
+        fprintf(stderr, "burst beyond the end of the table\n");
+        return false;
+      }
+      for (int k = 0; k < value; k++)
+        entries.push_back({false, pairs[data] + k, pairs[data + 1 + k]});
+      j += ((value / 2) + 1) * 2;
+    } else {
+      entries.push_back({false, reg, value});
+    }
+  }
+  return true;
+}
+
+/// Parses a TI .cfg script
+static bool parse_cfg(const std::string &content,
+                      std::vector<Entry> &entries) {
+  size_t pos = 0;
+  int line_no = 0;
+  int next_reg = -1;
+  while (pos < content.size()) {
+    size_t eol = content.find('\n', pos);
+    if (eol == std::string::npos) eol = content.size();
+    std::string line = content.substr(pos, eol - pos);
+    pos = eol + 1;
+    line_no++;
+    size_t hash = line.find('#');
+    if (hash != std::string::npos) line = line.substr(0, hash);
+    std::vector<int> values;
+    char cmd = 0;
+    char *p = (char *)line.c_str();
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == 0 || *p == '\r') continue;
+    cmd = *p++;
+    while (true) {
+      char *rest = nullptr;
+      long value = strtol(p, &rest, cmd == 'd' ? 10 : 16);
+      if (rest == p) break;
+      values.push_back((int)value);
+      p = rest;
+    }
+    if (cmd == 'w' && values.size() >= 3) {
+      // values[0] is the I2C address
+      int reg = values[1];
+      for (size_t k = 2; k < values.size(); k++)
+        entries.push_back({false, reg++, values[k]});
+      next_reg = reg;
+    } else if (cmd == '>' && next_reg >= 0) {
+      for (int value : values) entries.push_back({false, next_reg++, value});
+    } else if (cmd == 'd' && values.size() == 1) {
+      entries.push_back({true, 0, values[0]});
+    } else {
+      fprintf(stderr, "line %d: unsupported command\n", line_no);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Creates the stream: pending register writes of the same page are
+ * collected and encoded as bursts and fills
+ */
+class Compiler {
+ public:
+  Compiler(const Options &opt) : opt(opt) {
+    uint8_t flags = opt.burst ? REG_STREAM_AUTO_INCREMENT : 0;
+    out = {REG_STREAM_MAGIC_0, REG_STREAM_MAGIC_1, REG_STREAM_VERSION, flags,
+           (uint8_t)opt.page_reg, (uint8_t)opt.book_reg};
+  }
+
+  void add(const Entry &entry) {
+    if (entry.delay) {
+      flush();
+      out.push_back(REG_STREAM_DELAY);
+      out.push_back(entry.value & 0xFF);
+      out.push_back((entry.value >> 8) & 0xFF);
+      return;
+    }
+    if (opt.page_reg != REG_STREAM_NONE && entry.reg == opt.page_reg) {
+      if (page == entry.value) {
+        dropped++;
+        return;
+      }
+      flush();
+      page = entry.value;
+      out.push_back(REG_STREAM_PAGE);
+      out.push_back(entry.value);
+      return;
+    }
+    if (opt.book_reg != REG_STREAM_NONE && entry.reg == opt.book_reg &&
+        page == 0) {
+      if (book == entry.value) {
+        dropped++;
+        return;
+      }
+      flush();
+      book = entry.value;
+      out.push_back(REG_STREAM_BOOK);
+      out.push_back(entry.value);
+      return;
+    }
+    if (!pending.empty() &&
+        (entry.reg != pending_reg + (int)pending.size() || entry.reg > 0xFF))
+      flush();
+    if (pending.empty()) pending_reg = entry.reg;
+    pending.push_back((uint8_t)entry.value);
+    if (entry.reg == opt.reset_reg && page == 0) {
+      flush();
+      page = -1;
+      book = -1;
+      out.push_back(REG_STREAM_INVALIDATE);
+    }
+  }
+
+  std::vector<uint8_t> &finish() {
+    flush();
+    out.push_back(REG_STREAM_END);
+    return out;
+  }
+
+  int droppedSelects() { return dropped; }
+
+ protected:
+  const Options &opt;
+  std::vector<uint8_t> out;
+  std::vector<uint8_t> pending;
+  int pending_reg = 0;
+  int page = -1;
+  int book = -1;
+  int dropped = 0;
+
+  /// length of the run of equal values starting at pos
+  size_t runLength(size_t pos) {
+    size_t len = 1;
+    while (pos + len < pending.size() && pending[pos + len] == pending[pos] &&
+           len < (size_t)REG_STREAM_FILL_MAX)
+      len++;
+    return len;
+  }
+
+  void flush() {
+    size_t pos = 0;
+    while (pos < pending.size()) {
+      size_t run = runLength(pos);
+      if (run >= 3) {
+        out.push_back(REG_STREAM_FILL | (uint8_t)(run - 1));
+        out.push_back((uint8_t)(pending_reg + pos));
+        out.push_back(pending[pos]);
+        pos += run;
+        continue;
+      }
+      // literal burst up to the next run of at least 4 equal values
+      size_t end = pos;
+      while (end < pending.size() && end - pos < REG_STREAM_BURST_MAX &&
+             runLength(end) < 4)
+        end++;
+      if (end == pos) end = pos + 1;
+      out.push_back((uint8_t)(end - pos));
+      out.push_back((uint8_t)(pending_reg + pos));
+      out.insert(out.end(), pending.begin() + pos, pending.begin() + end);
+      pos = end;
+    }
+    pending.clear();
+  }
+};
+
+static bool write_output(const Options &opt, const std::vector<uint8_t> &data) {
+  FILE *file = fopen(opt.output.c_str(), opt.name.empty() ? "wb" : "w");
+  if (file == nullptr) return false;
+  if (opt.name.empty()) {
+    fwrite(data.data(), 1, data.size(), file);
+  } else {
+    fprintf(file,
+            "// Generated by tools/regstream from %s: do not edit\n"
+            "#pragma once\n#include <stdint.h>\n\nnamespace audio_driver {\n\n"
+            "static constexpr uint8_t %s[] = {",
+            opt.input.c_str(), opt.name.c_str());
+    for (size_t j = 0; j < data.size(); j++) {
+      fprintf(file, "%s0x%02x,", j % 12 == 0 ? "\n    " : " ", data[j]);
+    }
+    fprintf(file, "\n};\n\n}  // namespace audio_driver\n");
+  }
+  fclose(file);
+  return true;
+}
+
+static int usage() {
+  fprintf(stderr,
+          "usage: regstream [--page-reg r] [--book-reg r] [--reset-reg r] "
+          "[--table name] [--name name] [--no-burst] <input> <output>\n");
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  for (int j = 1; j < argc; j++) {
+    std::string arg = argv[j];
+    bool has_value = j + 1 < argc;
+    if (arg == "--page-reg" && has_value) {
+      opt.page_reg = (int)strtol(argv[++j], nullptr, 0);
+    } else if (arg == "--book-reg" && has_value) {
+      opt.book_reg = (int)strtol(argv[++j], nullptr, 0);
+    } else if (arg == "--reset-reg" && has_value) {
+      opt.reset_reg = (int)strtol(argv[++j], nullptr, 0);
+    } else if (arg == "--table" && has_value) {
+      opt.table = argv[++j];
+    } else if (arg == "--name" && has_value) {
+      opt.name = argv[++j];
+    } else if (arg == "--no-burst") {
+      opt.burst = false;
+    } else if (arg[0] == '-') {
+      return usage();
+    } else if (opt.input.empty()) {
+      opt.input = arg;
+    } else {
+      opt.output = arg;
+    }
+  }
+  if (opt.input.empty() || opt.output.empty()) return usage();
+
+  std::string content;
+  if (!read_file(opt.input, content)) {
+    fprintf(stderr, "can not read %s\n", opt.input.c_str());
+    return 1;
+  }
+  std::vector<Entry> entries;
+  bool is_table = content.find('{') != std::string::npos;
+  bool ok = is_table ? parse_table(content, opt, entries)
+                     : parse_cfg(content, entries);
+  if (!ok || entries.empty()) {
+    fprintf(stderr, "no register writes found in %s\n", opt.input.c_str());
+    return 1;
+  }
+
+  Compiler compiler(opt);
+  for (auto &entry : entries) compiler.add(entry);
+  std::vector<uint8_t> &data = compiler.finish();
+  if (!write_output(opt, data)) {
+    fprintf(stderr, "can not write %s\n", opt.output.c_str());
+    return 1;
+  }
+  fprintf(stderr,
+          "%s: %d operations (%d bytes as table) -> %d bytes, %d redundant "
+          "page/book selects dropped\n",
+          opt.input.c_str(), (int)entries.size(), (int)entries.size() * 2,
+          (int)data.size(), compiler.droppedSelects());
+  return 0;
+}